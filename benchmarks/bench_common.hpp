@@ -0,0 +1,46 @@
+#pragma once
+
+#include "hellofitty.hpp"
+
+#include <TH1.h>
+
+#include <cmath>
+#include <memory>
+#include <string>
+
+namespace bench
+{
+
+/// Histogram with noiseless gaussian peak on a linear background, the content is fully deterministic.
+inline auto make_gaus_pol_hist(const std::string& name, int bins) -> std::unique_ptr<TH1D>
+{
+    TH1::AddDirectory(false);
+    auto hist = std::make_unique<TH1D>(name.c_str(), "", bins, 0, 10);
+    for (int i = 1; i <= bins; ++i)
+    {
+        const auto x = hist->GetXaxis()->GetBinCenter(i);
+        const auto content = 1000.0 * std::exp(-0.5 * (x - 5.0) * (x - 5.0) / 0.25) + 100.0 - 5.0 * x;
+        hist->SetBinContent(i, content * 100.0 / bins);
+        hist->SetBinError(i, std::sqrt(content * 100.0 / bins));
+    }
+    return hist;
+}
+
+/// Entry matching make_gaus_pol_hist() with initial parameters off the true values.
+inline auto make_gaus_pol_entry() -> hf::entry
+{
+    hf::entry hfp(0, 10);
+    hfp.add_function("gaus(0)");
+    hfp.add_function("pol1(3)");
+    hfp.set_param(0, 800);
+    hfp.set_param(1, 4.8, 4, 6, hf::param::fit_mode::free);
+    hfp.set_param(2, 0.6, 0.1, 2, hf::param::fit_mode::free);
+    hfp.set_param(3, 90);
+    hfp.set_param(4, -4);
+    return hfp;
+}
+
+constexpr auto v1_line = " hist_1 gaus(0) expo(3) 0 1 10  1  2 : 1 3  3 F 2 5  4 f  5";
+constexpr auto v2_line = " hist_1 1 10 0 gaus(0) expo(3) | 1  2 : 1 3  3 F 2 5  4 f  5";
+
+} // namespace bench
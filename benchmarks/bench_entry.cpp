@@ -0,0 +1,27 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_common.hpp"
+
+#include "details.hpp"
+
+static void BM_EntryCopy(benchmark::State& state)
+{
+    const auto hfp = bench::make_gaus_pol_entry();
+    for (auto _ : state)
+    {
+        hf::entry copy(hfp);
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(BM_EntryCopy);
+
+static void BM_EntryCompile(benchmark::State& state)
+{
+    // formula_impl directly, entry_impl::compile() would return the interned formula after the first iteration
+    for (auto _ : state)
+    {
+        hf::detail::formula_impl formula({"gaus(0)", "pol1(3)"}, 0, 10);
+        benchmark::DoNotOptimize(formula);
+    }
+}
+BENCHMARK(BM_EntryCompile);
@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_common.hpp"
+
+#include <TList.h>
+
+#include <fmt/core.h>
+
+#include <string>
+#include <vector>
+
+static auto make_silent_fitter() -> hf::fitter
+{
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    return fitter;
+}
+
+static void BM_FindFit(benchmark::State& state)
+{
+    auto fitter = make_silent_fitter();
+    const auto generic = bench::make_gaus_pol_entry();
+
+    // names are formatted once, so only the lookup is timed
+    const auto entries = state.range(0);
+    std::vector<std::string> names;
+    names.reserve(static_cast<std::size_t>(entries));
+    for (int64_t i = 0; i < entries; ++i)
+    {
+        names.push_back(fmt::format("h_{:d}", i));
+        fitter.insert_parameter(names.back(), generic);
+    }
+
+    std::size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fitter.find_fit(names[i].c_str()));
+        i = (i + 7919) % names.size();
+    }
+}
+BENCHMARK(BM_FindFit)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Fit(benchmark::State& state)
+{
+    auto fitter = make_silent_fitter();
+    auto hist = bench::make_gaus_pol_hist("h_bench", static_cast<int>(state.range(0)));
+    const auto initial = bench::make_gaus_pol_entry();
+    auto hfp = fitter.insert_parameter(hist->GetName(), initial);
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < initial.get_function_params_count(); ++i)
+        {
+            hfp->set_param(i, initial.get_param(i));
+        }
+        benchmark::DoNotOptimize(fitter.fit(hfp, hist.get(), "BQS0N"));
+        // partial functions are attached to the histogram on each fit
+        hist->GetListOfFunctions()->Delete();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Fit)->RangeMultiplier(10)->Range(100, 100000)->Unit(benchmark::kMillisecond);
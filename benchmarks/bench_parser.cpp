@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_common.hpp"
+
+#include "parser.hpp"
+
+static void BM_ParserV1Parse(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(hf::parser::v1::parse_line_entry(bench::v1_line));
+    }
+}
+BENCHMARK(BM_ParserV1Parse);
+
+static void BM_ParserV2Parse(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(hf::parser::v2::parse_line_entry(bench::v2_line));
+    }
+}
+BENCHMARK(BM_ParserV2Parse);
+
+static void BM_ParserV1Format(benchmark::State& state)
+{
+    const auto hfp = hf::parser::v1::parse_line_entry(bench::v1_line);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(hf::parser::v1::format_line_entry(hfp.first, &hfp.second));
+    }
+}
+BENCHMARK(BM_ParserV1Format);
+
+static void BM_ParserV2Format(benchmark::State& state)
+{
+    const auto hfp = hf::parser::v2::parse_line_entry(bench::v2_line);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(hf::parser::v2::format_line_entry(hfp.first, &hfp.second));
+    }
+}
+BENCHMARK(BM_ParserV2Format);
@@ -0,0 +1,26 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_common.hpp"
+
+#include <string>
+
+static void BM_DetectFormat(benchmark::State& state)
+{
+    const std::string line = state.range(0) == 1 ? bench::v1_line : bench::v2_line;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(hf::tools::detect_format(line));
+    }
+}
+BENCHMARK(BM_DetectFormat)->Arg(1)->Arg(2);
+
+static void BM_FormatName(benchmark::State& state)
+{
+    const std::string name = "h_tof_sector3_module12_strip45";
+    const std::string decorator = "f_*_v2";
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(hf::tools::format_name(name, decorator));
+    }
+}
+BENCHMARK(BM_FormatName);
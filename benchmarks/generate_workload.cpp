@@ -0,0 +1,112 @@
+#include "workload.hpp"
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+auto usage(const char* argv0) -> void
+{
+    fmt::print(stderr,
+               "Usage: {} [options]\n"
+               "  --entries N        number of entries (default 1000)\n"
+               "  --seed S           random seed (default 42)\n"
+               "  --format v1|v2     parameter file format (default v2)\n"
+               "  --mix m:w[,m:w]    model mix with weights, models: gaus_pol0, gaus_pol1, gaus_expo,\n"
+               "                     gaus_gaus_pol2 (default gaus_pol1:1)\n"
+               "  --fixed R          fraction of fixed params (default 0.1)\n"
+               "  --limits R         fraction of params with limits (default 0.3)\n"
+               "  --disabled R       fraction of '@'-disabled entries (default 0.05)\n"
+               "  --bins N           histogram bins (default 100)\n"
+               "  --range MIN MAX    histogram and fit range (default 0 10)\n"
+               "  --stats N          expected counts per histogram (default 10000)\n"
+               "  --params FILE      output parameter file\n"
+               "  --root FILE        output ROOT file with histograms\n",
+               argv0);
+}
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int
+{
+    bench::workload_config cfg;
+    std::string params_file;
+    std::string root_file;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto has_value = [&](int n) { return i + n < argc; };
+        const std::string arg = argv[i];
+
+        if (arg == "--entries" and has_value(1)) { cfg.entries = std::strtoull(argv[++i], nullptr, 10); }
+        else if (arg == "--seed" and has_value(1))
+        {
+            cfg.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--format" and has_value(1))
+        {
+            const std::string format = argv[++i];
+            if (format == "v1") { cfg.version = hf::format_version::v1; }
+            else if (format == "v2") { cfg.version = hf::format_version::v2; }
+            else
+            {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg == "--mix" and has_value(1)) { cfg.mix = bench::parse_mix(argv[++i]); }
+        else if (arg == "--fixed" and has_value(1)) { cfg.fixed_ratio = std::atof(argv[++i]); }
+        else if (arg == "--limits" and has_value(1)) { cfg.limits_ratio = std::atof(argv[++i]); }
+        else if (arg == "--disabled" and has_value(1)) { cfg.disabled_ratio = std::atof(argv[++i]); }
+        else if (arg == "--bins" and has_value(1)) { cfg.bins = std::atoi(argv[++i]); }
+        else if (arg == "--range" and has_value(2))
+        {
+            cfg.range_min = std::atof(argv[++i]);
+            cfg.range_max = std::atof(argv[++i]);
+        }
+        else if (arg == "--stats" and has_value(1)) { cfg.statistics = std::atof(argv[++i]); }
+        else if (arg == "--params" and has_value(1)) { params_file = argv[++i]; }
+        else if (arg == "--root" and has_value(1)) { root_file = argv[++i]; }
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (params_file.empty() and root_file.empty())
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<bench::workload_entry> entries;
+    try
+    {
+        entries = bench::generate_entries(cfg);
+    }
+    catch (const std::invalid_argument& e)
+    {
+        fmt::print(stderr, "{:s}\n", e.what());
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!params_file.empty())
+    {
+        if (!bench::write_parameter_file(cfg, entries, params_file)) { return EXIT_FAILURE; }
+        fmt::print("Written {:d} entries to {:s}\n", entries.size(), params_file);
+    }
+
+    if (!root_file.empty())
+    {
+        if (!bench::write_histogram_file(cfg, entries, root_file)) { return EXIT_FAILURE; }
+        fmt::print("Written {:d} histograms to {:s}\n", entries.size(), root_file);
+    }
+
+    return EXIT_SUCCESS;
+}
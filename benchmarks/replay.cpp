@@ -0,0 +1,241 @@
+#include "hellofitty.hpp"
+
+#include <TH1.h>
+#include <TROOT.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+struct options
+{
+    std::string capture;
+    std::size_t threads {1};
+    std::size_t repeat {1};
+};
+
+/// Captured fit ready for fitting: histogram and the entry as it was before the fit.
+struct replay_fit
+{
+    std::unique_ptr<TH1D> hist;
+    std::unique_ptr<hf::entry> hfp;
+    std::string options;
+};
+
+struct worker_report
+{
+    std::vector<double> latencies;
+    std::map<std::string, std::size_t> statuses;
+    std::uint64_t allocations {0};
+    std::uint64_t allocated_bytes {0};
+};
+
+auto usage(const char* argv0) -> void
+{
+    fmt::print(stderr,
+               "Usage: {} [options] capture_file\n"
+               "  --threads N  number of fitting threads, each with own fitter and histograms (default 1)\n"
+               "  --repeat N   number of passes over the capture (default 1)\n",
+               argv0);
+}
+
+auto status_name(hf::fitter::fit_status status) -> const char*
+{
+    switch (status)
+    {
+        case hf::fitter::fit_status::ok:
+            return "ok";
+        case hf::fitter::fit_status::failed:
+            return "failed";
+        case hf::fitter::fit_status::empty_range:
+            return "empty_range";
+        case hf::fitter::fit_status::missing_entry:
+            return "missing_entry";
+        case hf::fitter::fit_status::qa_worse_chi2:
+            return "qa_worse_chi2";
+        case hf::fitter::fit_status::skipped:
+            return "skipped";
+        case hf::fitter::fit_status::rejected:
+            return "rejected";
+    }
+    return "unknown";
+}
+
+auto make_replay_fit(const hf::captured_fit& fit) -> replay_fit
+{
+    replay_fit replay;
+    const auto bins = static_cast<int>(fit.contents.size());
+    replay.hist = std::make_unique<TH1D>(fit.name.c_str(), "", bins, fit.edges.data());
+    for (int i = 0; i < bins; ++i)
+    {
+        replay.hist->SetBinContent(i + 1, fit.contents[static_cast<std::size_t>(i)]);
+        replay.hist->SetBinError(i + 1, fit.errors[static_cast<std::size_t>(i)]);
+    }
+    const auto parsed = hf::tools::parse_line_entry(fit.entry_line);
+    replay.hfp = std::make_unique<hf::entry>(parsed.second);
+    replay.options = fit.options;
+    return replay;
+}
+
+/// Replay the slice of the capture. Each fit starts from the captured entry, the copy is made outside of the timing.
+auto run_worker(const std::vector<hf::captured_fit>& fits, std::size_t worker, std::size_t workers,
+                std::size_t repeat) -> worker_report
+{
+    worker_report report;
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+
+    std::vector<replay_fit> replays;
+    for (std::size_t i = worker; i < fits.size(); i += workers)
+    {
+        if (fits[i].contents.empty()) { continue; }
+
+        // the entry line is parsed here, a damaged one is reported with the statuses instead of ending the replay
+        try
+        {
+            replays.push_back(make_replay_fit(fits[i]));
+        }
+        catch (const std::exception&)
+        {
+            ++report.statuses["corrupt"];
+        }
+    }
+
+    report.latencies.reserve(replays.size() * repeat);
+    for (std::size_t pass = 0; pass < repeat; ++pass)
+    {
+        for (const auto& replay : replays)
+        {
+            hf::entry hfp(*replay.hfp);
+
+            const auto start = clock_type::now();
+            const auto result = fitter.fit(&hfp, replay.hist.get(), replay.options.c_str(), "");
+            report.latencies.push_back(std::chrono::duration<double>(clock_type::now() - start).count());
+
+            ++report.statuses[status_name(result.status)];
+        }
+    }
+
+    const auto stats = fitter.stats();
+    report.allocations = stats.alloc_fit_count;
+    report.allocated_bytes = stats.alloc_fit_bytes;
+
+    return report;
+}
+
+auto percentile(std::vector<double>& values, double q) -> double
+{
+    if (values.empty()) { return 0; }
+    const auto rank = static_cast<std::size_t>(q * static_cast<double>(values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(rank), values.end());
+    return values[rank];
+}
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int
+{
+    options opts;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto has_value = [&](int n) { return i + n < argc; };
+        const std::string arg = argv[i];
+
+        if (arg == "--threads" and has_value(1)) { opts.threads = std::strtoull(argv[++i], nullptr, 10); }
+        else if (arg == "--repeat" and has_value(1)) { opts.repeat = std::strtoull(argv[++i], nullptr, 10); }
+        else if (opts.capture.empty() and arg.compare(0, 2, "--") != 0) { opts.capture = arg; }
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (opts.capture.empty() or opts.threads == 0 or opts.repeat == 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<hf::captured_fit> fits;
+    try
+    {
+        fits = hf::tools::read_capture(opts.capture);
+    }
+    catch (const std::exception& e)
+    {
+        fmt::print(stderr, "{:s}\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    TH1::AddDirectory(false);
+    if (opts.threads > 1) { ROOT::EnableThreadSafety(); }
+
+    std::vector<worker_report> reports(opts.threads);
+    std::vector<std::thread> pool;
+
+    const auto begin = clock_type::now();
+    for (std::size_t t = 0; t < opts.threads; ++t)
+    {
+        pool.emplace_back([&, t] { reports[t] = run_worker(fits, t, opts.threads, opts.repeat); });
+    }
+    for (auto& thread : pool)
+    {
+        thread.join();
+    }
+    const auto wall_seconds = std::chrono::duration<double>(clock_type::now() - begin).count();
+
+    std::vector<double> latencies;
+    std::map<std::string, std::size_t> statuses;
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+    for (const auto& report : reports)
+    {
+        latencies.insert(latencies.end(), report.latencies.begin(), report.latencies.end());
+        allocations += report.allocations;
+        allocated_bytes += report.allocated_bytes;
+        for (const auto& status : report.statuses)
+        {
+            statuses[status.first] += status.second;
+        }
+    }
+
+    // wall time includes building the histograms of each thread
+    fmt::print("captured fits: {:d}, replayed: {:d}, threads: {:d}\n", fits.size(), latencies.size(), opts.threads);
+    fmt::print("wall: {:.3f} s, {:.1f} fits/s, p50 {:.3f} ms, p99 {:.3f} ms\n", wall_seconds,
+               wall_seconds > 0 ? static_cast<double>(latencies.size()) / wall_seconds : 0.0,
+               percentile(latencies, 0.50) * 1e3, percentile(latencies, 0.99) * 1e3);
+#ifdef HELLOFITTY_REPLAY_ALLOC_TRACKER
+    if (!latencies.empty())
+    {
+        const auto fits_count = static_cast<double>(latencies.size());
+        fmt::print("allocations per fit: {:.1f}, bytes per fit: {:.0f}\n",
+                   static_cast<double>(allocations) / fits_count, static_cast<double>(allocated_bytes) / fits_count);
+    }
+#else
+    // without the tracker the counters stay zero, which would read as allocation-free fits
+    fmt::print("allocations per fit: not tracked\n");
+#endif
+    for (const auto& status : statuses)
+    {
+        fmt::print("  {:s}: {:d}\n", status.first, status.second);
+    }
+
+    return EXIT_SUCCESS;
+}
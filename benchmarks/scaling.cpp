@@ -0,0 +1,500 @@
+#include "workload.hpp"
+
+#include <TROOT.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+struct options
+{
+    bench::workload_config workload;
+    std::vector<std::size_t> threads {1};
+    std::vector<std::size_t> processes {1};
+    std::string work_dir {"."};
+    std::string output;
+    bool json {false};
+    bool shared {false};
+};
+
+/// Fixed-size part of the worker report sent over the pipe, followed by the latencies.
+struct worker_header
+{
+    std::uint64_t fits;
+    std::uint64_t fits_ok;
+    double import_seconds;
+    double export_seconds;
+    std::int64_t fit_begin_ns; // steady clock is system-wide on Linux, so comparable between processes
+    std::int64_t fit_end_ns;
+    std::int64_t peak_rss_kb;
+    std::uint64_t latencies;
+};
+
+struct worker_report
+{
+    worker_header header;
+    std::vector<double> latencies;
+};
+
+/// Aggregated result of a single (processes, threads) configuration.
+struct scaling_result
+{
+    std::size_t processes;
+    std::size_t threads;
+    std::uint64_t fits {0};
+    std::uint64_t fits_ok {0};
+    double wall_seconds {0};
+    double fits_per_second {0};
+    double p50_ms {0};
+    double p99_ms {0};
+    double peak_rss_mb {0};    ///< largest process
+    double total_rss_mb {0};   ///< sum of all processes
+    double import_seconds {0}; ///< slowest worker
+    double export_seconds {0}; ///< slowest worker
+};
+
+auto usage(const char* argv0) -> void
+{
+    fmt::print(stderr,
+               "Usage: {} [options]\n"
+               "  --entries N        number of entries (default 1000)\n"
+               "  --seed S           random seed (default 42)\n"
+               "  --mix m:w[,m:w]    model mix with weights (default gaus_pol1:1)\n"
+               "  --bins N           histogram bins (default 100)\n"
+               "  --stats N          expected counts per histogram (default 10000)\n"
+               "  --threads N[,N]    thread counts per process to sweep (default 1)\n"
+               "  --processes N[,N]  process counts to sweep (default 1)\n"
+               "  --shared           threads of a process fit with one fitter instead of one fitter each\n"
+               "  --work-dir DIR     directory for the parameter files (default .)\n"
+               "  --format csv|json  report format (default csv)\n"
+               "  --output FILE      report file (default stdout)\n",
+               argv0);
+}
+
+auto parse_list(const char* spec) -> std::vector<std::size_t>
+{
+    std::vector<std::size_t> values;
+    for (const char* pos = spec; *pos;)
+    {
+        char* end = nullptr;
+        const auto value = std::strtoull(pos, &end, 10);
+        if (end == pos) { return {}; }
+        if (value > 0) { values.push_back(value); }
+        pos = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+auto now_ns() -> std::int64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+}
+
+auto peak_rss_kb() -> std::int64_t
+{
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+auto write_all(int fd, const void* data, std::size_t size) -> bool
+{
+    const auto* ptr = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        const auto written = ::write(fd, ptr, size);
+        if (written <= 0) { return false; }
+        ptr += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+auto read_all(int fd, void* data, std::size_t size) -> bool
+{
+    auto* ptr = static_cast<char*>(data);
+    while (size > 0)
+    {
+        const auto got = ::read(fd, ptr, size);
+        if (got <= 0) { return false; }
+        ptr += got;
+        size -= static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+/// Simple one-shot barrier, so all threads of the process start fitting together.
+class start_barrier
+{
+public:
+    explicit start_barrier(std::size_t count)
+        : m_count(count)
+    {
+    }
+
+    auto wait() -> void
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (--m_count == 0) { m_cv.notify_all(); }
+        else { m_cv.wait(lock, [this] { return m_count == 0; }); }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::size_t m_count;
+};
+
+/// Fit the slice of histograms of a single thread, starting together with the other threads of the process.
+auto fit_slice(hf::fitter& fitter, const std::vector<std::unique_ptr<TH1D>>& hists, start_barrier& barrier)
+    -> worker_report
+{
+    worker_report report {};
+
+    report.latencies.reserve(hists.size());
+    barrier.wait();
+
+    report.header.fit_begin_ns = now_ns();
+    for (const auto& hist : hists)
+    {
+        const auto start = clock_type::now();
+        const auto result = fitter.fit(hist.get(), "BQS0N");
+        report.latencies.push_back(std::chrono::duration<double>(clock_type::now() - start).count());
+
+        ++report.header.fits;
+        if (result) { ++report.header.fits_ok; }
+    }
+    report.header.fit_end_ns = now_ns();
+    report.header.latencies = report.latencies.size();
+
+    return report;
+}
+
+auto make_fitter(const std::string& params_file, const std::string& output_file) -> std::unique_ptr<hf::fitter>
+{
+    auto fitter = std::make_unique<hf::fitter>();
+    fitter->set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    fitter->init_from_file(params_file, output_file, hf::fitter::priority_mode::reference);
+    return fitter;
+}
+
+/// Export the fitter and record its import and export times in the reports of the threads which used it.
+auto finish_fitter(hf::fitter& fitter, const std::string& output_file, std::vector<worker_report>::iterator first,
+                   std::vector<worker_report>::iterator last) -> void
+{
+    fitter.export_to_file();
+
+    const auto stats = fitter.stats();
+    for (auto it = first; it != last; ++it)
+    {
+        it->header.import_seconds = stats.import_seconds;
+        it->header.export_seconds = stats.export_seconds;
+    }
+
+    std::remove(output_file.c_str());
+}
+
+/// Body of a forked process: prepare histograms of all its workers, run them and send reports to the pipe.
+auto run_process(const options& opts, const std::vector<bench::workload_entry>& entries,
+                 const std::string& params_file, std::size_t process, std::size_t processes, std::size_t threads,
+                 int fd) -> bool
+{
+    if (threads > 1) { ROOT::EnableThreadSafety(); }
+
+    // round-robin slices keep the model mix of each worker the same as the whole workload
+    const auto workers = processes * threads;
+    std::vector<std::vector<std::unique_ptr<TH1D>>> hists(threads);
+    for (const auto& entry : entries)
+    {
+        if (entry.disabled or entry.index % workers / threads != process) { continue; }
+        hists[entry.index % workers % threads].push_back(bench::make_histogram(opts.workload, entry));
+    }
+
+    start_barrier barrier(threads);
+    std::vector<worker_report> reports(threads);
+    std::vector<std::thread> pool;
+
+    if (opts.shared)
+    {
+        // all threads fit concurrently into the same registry
+        const auto output_file = fmt::format("{:s}/scaling_out_{:d}.txt", opts.work_dir, process);
+        const auto fitter = make_fitter(params_file, output_file);
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            pool.emplace_back([&, t] { reports[t] = fit_slice(*fitter, hists[t], barrier); });
+        }
+        for (auto& thread : pool)
+        {
+            thread.join();
+        }
+        finish_fitter(*fitter, output_file, reports.begin(), reports.end());
+    }
+    else
+    {
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            pool.emplace_back(
+                [&, t]
+                {
+                    const auto output_file =
+                        fmt::format("{:s}/scaling_out_{:d}_{:d}.txt", opts.work_dir, process, t);
+                    const auto fitter = make_fitter(params_file, output_file);
+                    const auto report = reports.begin() + static_cast<std::ptrdiff_t>(t);
+                    *report = fit_slice(*fitter, hists[t], barrier);
+                    finish_fitter(*fitter, output_file, report, report + 1);
+                });
+        }
+        for (auto& thread : pool)
+        {
+            thread.join();
+        }
+    }
+
+    const auto rss = peak_rss_kb();
+    for (auto& report : reports)
+    {
+        report.header.peak_rss_kb = rss;
+        if (!write_all(fd, &report.header, sizeof(report.header))) { return false; }
+        if (!write_all(fd, report.latencies.data(), report.latencies.size() * sizeof(double))) { return false; }
+    }
+    return true;
+}
+
+auto percentile(std::vector<double>& values, double q) -> double
+{
+    if (values.empty()) { return 0; }
+    const auto rank = static_cast<std::size_t>(q * static_cast<double>(values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(rank), values.end());
+    return values[rank];
+}
+
+/// Fork the processes of the configuration and aggregate their reports. Each configuration runs in fresh processes,
+/// so the peak RSS is not inherited from the previous one.
+auto run_configuration(const options& opts, const std::vector<bench::workload_entry>& entries,
+                       const std::string& params_file, std::size_t processes, std::size_t threads)
+    -> scaling_result
+{
+    struct child
+    {
+        pid_t pid;
+        int fd;
+    };
+
+    std::fflush(stdout);
+    std::vector<child> children;
+    for (std::size_t p = 0; p < processes; ++p)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            fmt::print(stderr, "Can't create pipe: {:s}\n", std::strerror(errno));
+            std::exit(EXIT_FAILURE);
+        }
+
+        const auto pid = fork();
+        if (pid < 0)
+        {
+            fmt::print(stderr, "Can't fork: {:s}\n", std::strerror(errno));
+            std::exit(EXIT_FAILURE);
+        }
+        if (pid == 0)
+        {
+            close(fds[0]);
+            const auto ok = run_process(opts, entries, params_file, p, processes, threads, fds[1]);
+            close(fds[1]);
+            _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+
+        close(fds[1]);
+        children.push_back({pid, fds[0]});
+    }
+
+    scaling_result result {processes, threads};
+    std::vector<double> latencies;
+    std::int64_t begin_ns = std::numeric_limits<std::int64_t>::max();
+    std::int64_t end_ns = std::numeric_limits<std::int64_t>::min();
+
+    for (const auto& c : children)
+    {
+        std::int64_t rss_kb = 0;
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            worker_header header {};
+            if (!read_all(c.fd, &header, sizeof(header))) { break; }
+
+            const auto offset = latencies.size();
+            latencies.resize(offset + header.latencies);
+            if (!read_all(c.fd, latencies.data() + offset, header.latencies * sizeof(double))) { break; }
+
+            result.fits += header.fits;
+            result.fits_ok += header.fits_ok;
+            result.import_seconds = std::max(result.import_seconds, header.import_seconds);
+            result.export_seconds = std::max(result.export_seconds, header.export_seconds);
+            begin_ns = std::min(begin_ns, header.fit_begin_ns);
+            end_ns = std::max(end_ns, header.fit_end_ns);
+            rss_kb = header.peak_rss_kb;
+        }
+        close(c.fd);
+
+        int status = 0;
+        waitpid(c.pid, &status, 0);
+        if (!WIFEXITED(status) or WEXITSTATUS(status) != EXIT_SUCCESS)
+        {
+            fmt::print(stderr, "Worker process {:d} failed\n", c.pid);
+        }
+
+        result.peak_rss_mb = std::max(result.peak_rss_mb, static_cast<double>(rss_kb) / 1024.0);
+        result.total_rss_mb += static_cast<double>(rss_kb) / 1024.0;
+    }
+
+    if (end_ns > begin_ns) { result.wall_seconds = static_cast<double>(end_ns - begin_ns) * 1e-9; }
+    if (result.wall_seconds > 0) { result.fits_per_second = static_cast<double>(result.fits) / result.wall_seconds; }
+    result.p50_ms = percentile(latencies, 0.50) * 1e3;
+    result.p99_ms = percentile(latencies, 0.99) * 1e3;
+
+    return result;
+}
+
+auto format_csv(const std::vector<scaling_result>& results) -> std::string
+{
+    std::string out = "processes,threads,fits,fits_ok,wall_seconds,fits_per_second,p50_ms,p99_ms,peak_rss_mb,"
+                      "total_rss_mb,import_seconds,export_seconds\n";
+    for (const auto& r : results)
+    {
+        out += fmt::format("{:d},{:d},{:d},{:d},{:g},{:g},{:g},{:g},{:g},{:g},{:g},{:g}\n", r.processes, r.threads,
+                           r.fits, r.fits_ok, r.wall_seconds, r.fits_per_second, r.p50_ms, r.p99_ms, r.peak_rss_mb,
+                           r.total_rss_mb, r.import_seconds, r.export_seconds);
+    }
+    return out;
+}
+
+auto format_json(const options& opts, const std::vector<scaling_result>& results) -> std::string
+{
+    std::string out = fmt::format("{{\n  \"entries\": {:d},\n  \"seed\": {:d},\n  \"bins\": {:d},\n"
+                                  "  \"shared\": {:s},\n  \"results\": [",
+                                  opts.workload.entries, opts.workload.seed, opts.workload.bins,
+                                  opts.shared ? "true" : "false");
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& r = results[i];
+        out += fmt::format("{:s}\n    {{\"processes\": {:d}, \"threads\": {:d}, \"fits\": {:d}, \"fits_ok\": {:d}, "
+                           "\"wall_seconds\": {:g}, \"fits_per_second\": {:g}, \"p50_ms\": {:g}, \"p99_ms\": {:g}, "
+                           "\"peak_rss_mb\": {:g}, \"total_rss_mb\": {:g}, \"import_seconds\": {:g}, "
+                           "\"export_seconds\": {:g}}}",
+                           i == 0 ? "" : ",", r.processes, r.threads, r.fits, r.fits_ok, r.wall_seconds,
+                           r.fits_per_second, r.p50_ms, r.p99_ms, r.peak_rss_mb, r.total_rss_mb, r.import_seconds,
+                           r.export_seconds);
+    }
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int
+{
+    options opts;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto has_value = [&](int n) { return i + n < argc; };
+        const std::string arg = argv[i];
+
+        if (arg == "--entries" and has_value(1)) { opts.workload.entries = std::strtoull(argv[++i], nullptr, 10); }
+        else if (arg == "--seed" and has_value(1))
+        {
+            opts.workload.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--mix" and has_value(1)) { opts.workload.mix = bench::parse_mix(argv[++i]); }
+        else if (arg == "--bins" and has_value(1)) { opts.workload.bins = std::atoi(argv[++i]); }
+        else if (arg == "--stats" and has_value(1)) { opts.workload.statistics = std::atof(argv[++i]); }
+        else if (arg == "--threads" and has_value(1)) { opts.threads = parse_list(argv[++i]); }
+        else if (arg == "--processes" and has_value(1)) { opts.processes = parse_list(argv[++i]); }
+        else if (arg == "--work-dir" and has_value(1)) { opts.work_dir = argv[++i]; }
+        else if (arg == "--format" and has_value(1) and
+                 (std::strcmp(argv[i + 1], "csv") == 0 or std::strcmp(argv[i + 1], "json") == 0))
+        {
+            opts.json = std::strcmp(argv[++i], "json") == 0;
+        }
+        else if (arg == "--output" and has_value(1)) { opts.output = argv[++i]; }
+        else if (arg == "--shared") { opts.shared = true; }
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (opts.threads.empty() or opts.processes.empty())
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    TH1::AddDirectory(false);
+
+    std::vector<bench::workload_entry> entries;
+    try
+    {
+        entries = bench::generate_entries(opts.workload);
+    }
+    catch (const std::invalid_argument& e)
+    {
+        fmt::print(stderr, "{:s}\n", e.what());
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const auto params_file = fmt::format("{:s}/scaling_pars.txt", opts.work_dir);
+    if (!bench::write_parameter_file(opts.workload, entries, params_file)) { return EXIT_FAILURE; }
+
+    std::vector<scaling_result> results;
+    for (const auto processes : opts.processes)
+    {
+        for (const auto threads : opts.threads)
+        {
+            results.push_back(run_configuration(opts, entries, params_file, processes, threads));
+            const auto& r = results.back();
+            fmt::print(stderr, "processes={:d} threads={:d}: {:.1f} fits/s, p50 {:.2f} ms, p99 {:.2f} ms\n",
+                       r.processes, r.threads, r.fits_per_second, r.p50_ms, r.p99_ms);
+        }
+    }
+
+    std::remove(params_file.c_str());
+
+    const auto report = opts.json ? format_json(opts, results) : format_csv(results);
+    if (opts.output.empty()) { fmt::print("{:s}", report); }
+    else
+    {
+        std::ofstream out(opts.output);
+        if (!out.is_open())
+        {
+            fmt::print(stderr, "Can't create output file {:s}.\n", opts.output);
+            return EXIT_FAILURE;
+        }
+        out << report;
+    }
+
+    return EXIT_SUCCESS;
+}
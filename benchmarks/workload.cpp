@@ -0,0 +1,259 @@
+#include "workload.hpp"
+
+#include <TF1.h>
+#include <TFile.h>
+#include <TRandom3.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+/// Independent, reproducible stream for each entry, so histograms do not depend on param file options.
+auto entry_seed(std::uint32_t seed, std::size_t index, std::uint32_t stream) -> UInt_t
+{
+    auto value = static_cast<std::uint64_t>(seed) * 0x9E3779B97F4A7C15ull + index * 0xBF58476D1CE4E5B9ull + stream;
+    value ^= value >> 31;
+    const auto result = static_cast<UInt_t>(value & 0xffffffffu);
+    return result != 0 ? result : 1; // TRandom3 seed 0 means random seed
+}
+
+auto join(const std::vector<std::string>& items, const char* sep) -> std::string
+{
+    std::string out;
+    for (const auto& item : items)
+    {
+        if (!out.empty()) { out += sep; }
+        out += item;
+    }
+    return out;
+}
+
+} // namespace
+
+namespace bench
+{
+
+auto available_models() -> const std::vector<workload_model>&
+{
+    static const std::vector<workload_model> models {
+        {"gaus_pol0",
+         {"gaus(0)", "pol0(3)"},
+         [](TRandom3& rng) -> std::vector<double> {
+             return {rng.Uniform(500, 2000), rng.Uniform(3, 7), rng.Uniform(0.3, 1.0), rng.Uniform(10, 100)};
+         }},
+        {"gaus_pol1",
+         {"gaus(0)", "pol1(3)"},
+         [](TRandom3& rng) -> std::vector<double> {
+             return {rng.Uniform(500, 2000), rng.Uniform(3, 7), rng.Uniform(0.3, 1.0), rng.Uniform(50, 100),
+                     rng.Uniform(-4, -1)};
+         }},
+        {"gaus_expo",
+         {"gaus(0)", "expo(3)"},
+         [](TRandom3& rng) -> std::vector<double> {
+             return {rng.Uniform(500, 2000), rng.Uniform(3, 7), rng.Uniform(0.3, 1.0), rng.Uniform(4, 6),
+                     rng.Uniform(-0.5, -0.1)};
+         }},
+        {"gaus_gaus_pol2",
+         {"gaus(0)", "gaus(3)", "pol2(6)"},
+         [](TRandom3& rng) -> std::vector<double> {
+             return {rng.Uniform(500, 2000), rng.Uniform(2, 4),    rng.Uniform(0.2, 0.5),
+                     rng.Uniform(500, 2000), rng.Uniform(6, 8),    rng.Uniform(0.2, 0.5),
+                     rng.Uniform(50, 100),   rng.Uniform(-4, -1), rng.Uniform(-0.1, 0.1)};
+         }},
+    };
+    return models;
+}
+
+auto parse_mix(const std::string& spec) -> std::vector<std::pair<std::string, double>>
+{
+    std::vector<std::pair<std::string, double>> mix;
+    std::size_t pos = 0;
+    while (pos < spec.size())
+    {
+        auto end = spec.find(',', pos);
+        if (end == std::string::npos) { end = spec.size(); }
+
+        const auto item = spec.substr(pos, end - pos);
+        const auto colon = item.find(':');
+        if (colon == std::string::npos) { mix.emplace_back(item, 1.0); }
+        else { mix.emplace_back(item.substr(0, colon), std::atof(item.c_str() + colon + 1)); }
+
+        pos = end + 1;
+    }
+    return mix;
+}
+
+auto generate_entries(const workload_config& cfg) -> std::vector<workload_entry>
+{
+    const auto& models = available_models();
+
+    if (cfg.mix.empty()) { throw std::invalid_argument("Empty model mix"); }
+    if (cfg.bins <= 0) { throw std::invalid_argument(fmt::format("Number of bins {:d} must be positive", cfg.bins)); }
+    if (!(cfg.range_min < cfg.range_max) or !std::isfinite(cfg.range_min) or !std::isfinite(cfg.range_max))
+    {
+        throw std::invalid_argument(fmt::format("Invalid range {:g} {:g}", cfg.range_min, cfg.range_max));
+    }
+
+    std::vector<std::pair<std::size_t, double>> mix;
+    for (const auto& item : cfg.mix)
+    {
+        // also rejects NaN, the picking below needs a positive total weight
+        if (!(item.second > 0.0) or !std::isfinite(item.second))
+        {
+            throw std::invalid_argument(fmt::format("Weight of model {:s} must be positive", item.first));
+        }
+
+        auto it = std::find_if(models.begin(), models.end(),
+                               [&](const workload_model& m) { return m.name == item.first; });
+        if (it == models.end()) { throw std::invalid_argument(fmt::format("Unknown model {:s}", item.first)); }
+        mix.emplace_back(static_cast<std::size_t>(std::distance(models.begin(), it)), item.second);
+    }
+    const auto total_weight =
+        std::accumulate(mix.begin(), mix.end(), 0.0, [](double sum, const auto& m) { return sum + m.second; });
+
+    std::vector<workload_entry> entries;
+    entries.reserve(cfg.entries);
+
+    const auto width = std::to_string(cfg.entries > 0 ? cfg.entries - 1 : 0).size();
+    for (std::size_t i = 0; i < cfg.entries; ++i)
+    {
+        TRandom3 rng(entry_seed(cfg.seed, i, 0));
+
+        auto pick = rng.Uniform(total_weight);
+        std::size_t model = mix.back().first;
+        for (const auto& m : mix)
+        {
+            if (pick < m.second)
+            {
+                model = m.first;
+                break;
+            }
+            pick -= m.second;
+        }
+
+        entries.push_back({i, fmt::format("{:s}{:0{}d}", cfg.name_prefix, i, width), model,
+                           models[model].true_params(rng), rng.Uniform() < cfg.disabled_ratio});
+    }
+
+    return entries;
+}
+
+auto format_entry(const workload_config& cfg, const workload_entry& entry, TRandom3& rng) -> std::string
+{
+    const auto& model = available_models()[entry.model];
+
+    std::string params;
+    for (const auto true_value : entry.true_params)
+    {
+        const auto value = true_value * (1.0 + rng.Uniform(-cfg.smearing, cfg.smearing));
+        const auto fixed = rng.Uniform() < cfg.fixed_ratio;
+        const auto limits = rng.Uniform() < cfg.limits_ratio;
+        const auto margin = std::max(std::abs(true_value) * 0.5, 0.1);
+
+        if (fixed and limits)
+        {
+            params += fmt::format("  {:g} F {:g} {:g}", true_value, true_value - margin, true_value + margin);
+        }
+        else if (fixed) { params += fmt::format("  {:g} f", true_value); }
+        else if (limits)
+        {
+            params += fmt::format("  {:g} : {:g} {:g}", value, true_value - margin, true_value + margin);
+        }
+        else { params += fmt::format("  {:g}", value); }
+    }
+
+    const auto marker = entry.disabled ? '@' : ' ';
+    if (cfg.version == hf::format_version::v1)
+    {
+        // v1 has exactly two functions, all but the last one are merged into the signal
+        const std::vector<std::string> signal(model.functions.begin(), std::prev(model.functions.end()));
+        return fmt::format("{:c}{:s}\t{:s} {:s} 0 {:.0f} {:.0f}{:s}", marker, entry.name, join(signal, "+"),
+                           model.functions.back(), cfg.range_min, cfg.range_max, params);
+    }
+
+    return fmt::format("{:c}{:s}\t{:g} {:g} 0 {:s} |{:s}", marker, entry.name, cfg.range_min, cfg.range_max,
+                       join(model.functions, " "), params);
+}
+
+auto make_histogram(const workload_config& cfg, const workload_entry& entry) -> std::unique_ptr<TH1D>
+{
+    const auto& model = available_models()[entry.model];
+
+    TF1 func("", join(model.functions, "+").c_str(), cfg.range_min, cfg.range_max, TF1::EAddToList::kNo);
+    for (std::size_t i = 0; i < entry.true_params.size(); ++i)
+    {
+        func.SetParameter(static_cast<int>(i), entry.true_params[i]);
+    }
+
+    TH1::AddDirectory(false);
+    auto hist = std::make_unique<TH1D>(entry.name.c_str(), "", cfg.bins, cfg.range_min, cfg.range_max);
+
+    std::vector<double> expected(static_cast<std::size_t>(cfg.bins));
+    for (int bin = 1; bin <= cfg.bins; ++bin)
+    {
+        expected[static_cast<std::size_t>(bin - 1)] = std::max(func.Eval(hist->GetXaxis()->GetBinCenter(bin)), 0.0);
+    }
+    const auto sum = std::accumulate(expected.begin(), expected.end(), 0.0);
+    const auto scale = sum > 0 ? cfg.statistics / sum : 0.0;
+
+    TRandom3 rng(entry_seed(cfg.seed, entry.index, 1));
+    for (int bin = 1; bin <= cfg.bins; ++bin)
+    {
+        const auto counts = static_cast<double>(rng.Poisson(expected[static_cast<std::size_t>(bin - 1)] * scale));
+        hist->SetBinContent(bin, counts);
+        hist->SetBinError(bin, std::sqrt(std::max(counts, 1.0)));
+    }
+    hist->SetEntries(cfg.statistics);
+
+    return hist;
+}
+
+auto write_parameter_file(const workload_config& cfg, const std::vector<workload_entry>& entries,
+                          const std::string& filename) -> bool
+{
+    std::ofstream parfile(filename);
+    if (!parfile.is_open())
+    {
+        fmt::print(stderr, "Can't create output file {:s}.\n", filename);
+        return false;
+    }
+
+    for (const auto& entry : entries)
+    {
+        TRandom3 rng(entry_seed(cfg.seed, entry.index, 2));
+        parfile << format_entry(cfg, entry, rng) << '\n';
+    }
+
+    return true;
+}
+
+auto write_histogram_file(const workload_config& cfg, const std::vector<workload_entry>& entries,
+                          const std::string& filename) -> bool
+{
+    std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "RECREATE"));
+    if (!file or file->IsZombie())
+    {
+        fmt::print(stderr, "Can't create output file {:s}.\n", filename);
+        return false;
+    }
+
+    for (const auto& entry : entries)
+    {
+        auto hist = make_histogram(cfg, entry);
+        file->cd();
+        hist->Write();
+    }
+
+    file->Close();
+    return true;
+}
+
+} // namespace bench
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "hellofitty.hpp"
+
+#include <TH1.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TRandom3;
+
+namespace bench
+{
+
+/// Fit model: functions in the parameter file and generator of the true parameters.
+struct workload_model
+{
+    std::string name;                                           ///< model name used in the mix specification
+    std::vector<std::string> functions;                         ///< function bodies, each a single token
+    std::function<std::vector<double>(TRandom3&)> true_params; ///< draws true parameters of the model
+};
+
+/// Synthetic workload description. All outputs are deterministic for the given seed.
+struct workload_config
+{
+    std::uint32_t seed {42};
+    std::size_t entries {1000};
+    std::string name_prefix {"h_"};
+    hf::format_version version {hf::format_version::v2};
+
+    /// Pairs of model name and relative weight, see available_models().
+    std::vector<std::pair<std::string, double>> mix {{"gaus_pol1", 1.0}};
+
+    double fixed_ratio {0.1};     ///< fraction of fixed params
+    double limits_ratio {0.3};    ///< fraction of params with limits
+    double disabled_ratio {0.05}; ///< fraction of '@'-disabled entries
+    double smearing {0.1};        ///< relative smearing of initial values against true values
+
+    int bins {100};
+    double range_min {0.0};
+    double range_max {10.0};
+    double statistics {10000.0}; ///< expected number of counts per histogram
+};
+
+/// Single generated entry.
+struct workload_entry
+{
+    std::size_t index;
+    std::string name;
+    std::size_t model;
+    std::vector<double> true_params;
+    bool disabled;
+};
+
+/// Models known to the generator: gaus_pol0, gaus_pol1, gaus_expo, gaus_gaus_pol2.
+auto available_models() -> const std::vector<workload_model>&;
+
+/// Parse model mix specification "model:weight,model:weight,...", missing weight means 1.
+auto parse_mix(const std::string& spec) -> std::vector<std::pair<std::string, double>>;
+
+/// Draw all entries of the workload.
+/// @throws std::invalid_argument if the mix is empty, has an unknown model or a weight which is not positive, if the
+/// number of bins is not positive or the range is empty
+auto generate_entries(const workload_config& cfg) -> std::vector<workload_entry>;
+
+/// Format the entry as parameter file line in the configured format.
+auto format_entry(const workload_config& cfg, const workload_entry& entry, TRandom3& rng) -> std::string;
+
+/// Sample histogram of the entry model with true parameters.
+auto make_histogram(const workload_config& cfg, const workload_entry& entry) -> std::unique_ptr<TH1D>;
+
+/// Write parameter file with all entries.
+auto write_parameter_file(const workload_config& cfg, const std::vector<workload_entry>& entries,
+                          const std::string& filename) -> bool;
+
+/// Write ROOT file with histograms of all entries.
+auto write_histogram_file(const workload_config& cfg, const std::vector<workload_entry>& entries,
+                          const std::string& filename) -> bool;
+
+} // namespace bench
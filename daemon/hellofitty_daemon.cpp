@@ -0,0 +1,93 @@
+#include "hellofitty_server.hpp"
+
+#include <TH1.h>
+#include <TROOT.h>
+
+#include <fmt/core.h>
+
+#include <csignal>
+#include <cstdlib>
+#include <string>
+
+#include <pthread.h>
+
+namespace
+{
+auto usage(const char* argv0) -> void
+{
+    fmt::print(stderr,
+               "Usage: {} --socket PATH --input FILE [options]\n"
+               "  --socket PATH          Unix socket to listen on\n"
+               "  --input FILE           reference parameters file\n"
+               "  --aux FILE             auxiliary parameters file, also the export target\n"
+               "  --workers N            fitting threads (default 1)\n"
+               "  --fit-options OPTS     options of each fit (default BQ0N)\n"
+               "  --export-interval S    seconds between exports, 0 disables (default 60)\n",
+               argv0);
+}
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int
+{
+    hf::server::options opts;
+    std::string input;
+    std::string aux;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto has_value = [&](int n) { return i + n < argc; };
+        const std::string arg = argv[i];
+
+        if (arg == "--socket" and has_value(1)) { opts.socket_path = argv[++i]; }
+        else if (arg == "--input" and has_value(1)) { input = argv[++i]; }
+        else if (arg == "--aux" and has_value(1)) { aux = argv[++i]; }
+        else if (arg == "--workers" and has_value(1)) { opts.workers = std::strtoull(argv[++i], nullptr, 10); }
+        else if (arg == "--fit-options" and has_value(1)) { opts.fit_options = argv[++i]; }
+        else if (arg == "--export-interval" and has_value(1)) { opts.export_interval = std::atof(argv[++i]); }
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (opts.socket_path.empty() or input.empty())
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // signals are taken by sigwait() below, all threads started later inherit the mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    TH1::AddDirectory(false);
+    if (opts.workers > 1) { ROOT::EnableThreadSafety(); }
+
+    hf::fitter fitter;
+    const auto loaded = aux.empty() ? fitter.init_from_file(input)
+                                    : fitter.init_from_file(input, aux, hf::fitter::priority_mode::newer);
+    if (!loaded)
+    {
+        fmt::print(stderr, "Can't load parameters from {:s}\n", input);
+        return EXIT_FAILURE;
+    }
+
+    hf::server server(fitter, opts);
+    if (!server.start())
+    {
+        fmt::print(stderr, "Can't listen on {:s}\n", opts.socket_path);
+        return EXIT_FAILURE;
+    }
+    fmt::print(stderr, "Listening on {:s}\n", opts.socket_path);
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+
+    server.stop();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,45 @@
+#ifndef HELLOFITTY_AFFINITY_H
+#define HELLOFITTY_AFFINITY_H
+
+#include "hellofitty.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hf::detail
+{
+
+/// CPUs a worker thread is pinned to. Empty cpus means the thread is not pinned.
+struct cpu_binding
+{
+    int node {-1}; ///< NUMA node, -1 if the binding is not to a node
+    std::vector<int> cpus;
+};
+
+/// Parse the kernel CPU list format, e.g. "0-3,8,10-11".
+/// @param list CPU list
+/// @return CPU numbers, empty if the list is malformed
+auto parse_cpu_list(const std::string& list) -> std::vector<int>;
+
+/// Assign CPUs to the workers according to the policy. Only the CPUs allowed to the process are used. Workers are
+/// spread round-robin over the CPUs or the NUMA nodes, so neighbouring workers land on different nodes.
+/// @param policy affinity policy
+/// @param threads number of workers
+/// @return binding of each worker, unpinned ones if the policy is none or the topology can't be read
+auto plan_bindings(fitter::affinity_policy policy, std::size_t threads) -> std::vector<cpu_binding>;
+
+/// Pin the thread.
+/// @param thread running thread
+/// @param binding CPUs to use
+/// @return true if the thread was pinned
+auto apply_binding(std::thread& thread, const cpu_binding& binding) -> bool;
+
+/// Describe the binding for the statistics, e.g. "cpu 3", "node 1: cpus 8-15" or "unpinned".
+/// @param binding the binding
+/// @return description
+auto format_binding(const cpu_binding& binding) -> std::string;
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_AFFINITY_H */
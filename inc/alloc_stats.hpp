@@ -0,0 +1,55 @@
+#ifndef HELLOFITTY_ALLOC_STATS_H
+#define HELLOFITTY_ALLOC_STATS_H
+
+#include "hellofitty.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace hf::detail
+{
+
+/// Fitter phases with own allocation counters.
+enum class alloc_phase : std::uint8_t
+{
+    import,
+    fit,
+    export_file,
+};
+
+constexpr std::size_t alloc_phase_count = 3;
+
+/// Allocations of one fitter made by the threads inside its phases. The counters are fed by the allocation tracker
+/// (source/alloc_tracker.cpp) replacing the global operator new; without it they stay zero.
+struct alloc_counters
+{
+    std::array<std::atomic<std::uint64_t>, alloc_phase_count> count {};
+    std::array<std::atomic<std::uint64_t>, alloc_phase_count> bytes {};
+};
+
+/// Count the allocation in the phase of the calling thread, if there is one. It must not allocate.
+/// @param size allocated bytes
+auto HELLOFITTY_EXPORT record_allocation(std::size_t size) noexcept -> void;
+
+/// Attribute allocations of the calling thread to the phase of the fitter while the scope exists. Scopes nest, the
+/// previous phase is restored at the end.
+class alloc_scope final
+{
+public:
+    alloc_scope(alloc_counters& counters, alloc_phase phase) noexcept;
+
+    alloc_scope(const alloc_scope&) = delete;
+    auto operator=(const alloc_scope&) -> alloc_scope& = delete;
+
+    ~alloc_scope();
+
+private:
+    alloc_counters* m_previous_counters;
+    alloc_phase m_previous_phase;
+};
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_ALLOC_STATS_H */
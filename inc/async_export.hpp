@@ -0,0 +1,56 @@
+#ifndef HELLOFITTY_ASYNC_EXPORT_H
+#define HELLOFITTY_ASYNC_EXPORT_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hf::detail
+{
+
+/// Runs exports on a single background thread, so at most one export is in flight. Requests for a file which is
+/// already waiting are merged with the waiting one and share its future.
+class async_exporter final
+{
+public:
+    using export_function = std::function<bool(const std::string&)>;
+
+    explicit async_exporter(export_function function);
+
+    async_exporter(const async_exporter&) = delete;
+    auto operator=(const async_exporter&) -> async_exporter& = delete;
+
+    /// Finish all waiting exports and stop the thread.
+    ~async_exporter();
+
+    /// Schedule export to the file.
+    /// @param filename output file
+    /// @return future result of the export function
+    auto request(std::string filename) -> std::shared_future<bool>;
+
+private:
+    struct pending_export
+    {
+        std::string filename;
+        std::promise<bool> promise;
+        std::shared_future<bool> future;
+    };
+
+    auto run() -> void;
+
+    export_function m_function;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<pending_export> m_pending;
+    bool m_stop {false};
+    std::thread m_thread;
+};
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_ASYNC_EXPORT_H */
@@ -0,0 +1,50 @@
+#ifndef HELLOFITTY_CAPTURE_H
+#define HELLOFITTY_CAPTURE_H
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class TH1;
+
+namespace hf::detail
+{
+
+/// Appends inputs of histogram fits to a binary trace. Records are serialized by the fitting threads and only the
+/// final write is serialized.
+///
+/// File layout, all numbers in the native byte order: the magic "HFCAP001", then records, each made of its size in
+/// bytes (u32) followed by the name, fit options and entry line (each as u32 length and characters), the number of
+/// bins n (u32), n + 1 bin edges, n contents and n errors (f64). A record cut by a crash is ignored by the reader.
+class capture_writer final
+{
+public:
+    /// Create the trace, the existing file is replaced.
+    /// @param filename trace file
+    /// @return writer or nullptr if the file could not be created
+    static auto open(const std::string& filename) -> std::unique_ptr<capture_writer>;
+
+    /// Append the fit inputs and flush them to the file. Only the bins covering the fit range are stored.
+    /// @param name histogram name
+    /// @param options fit options
+    /// @param entry_line entry before the fit, in the v2 format
+    /// @param hist fitted histogram
+    /// @param range_min fit range lower edge
+    /// @param range_max fit range upper edge
+    auto write(const std::string& name, const std::string& options, const std::string& entry_line, const TH1& hist,
+               double range_min, double range_max) -> void;
+
+private:
+    explicit capture_writer(std::ofstream stream)
+        : m_stream(std::move(stream))
+    {
+    }
+
+    std::mutex m_mutex;
+    std::ofstream m_stream;
+};
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_CAPTURE_H */
@@ -0,0 +1,90 @@
+#ifndef HELLOFITTY_CHECKPOINT_H
+#define HELLOFITTY_CHECKPOINT_H
+
+#include "hellofitty.hpp"
+
+#include "async_export.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace hf::detail
+{
+
+class entry_registry;
+
+/// Journal of fitted entries, used to resume an interrupted batch job. Fitted entries are collected in memory and
+/// appended to the journal on a background thread every N fits or T seconds, so the fitting never waits for the disk.
+/// Each appended batch is closed with a marker line; a batch without the marker, e.g. cut by a crash, is ignored when
+/// the journal is loaded and its histograms are fitted again.
+class checkpoint_journal final
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    /// @param filename journal file
+    /// @param every_fits append after that many fits, zero disables the count trigger
+    /// @param interval append after that many seconds since the last append, zero disables the time trigger
+    checkpoint_journal(std::string filename, std::size_t every_fits, double interval);
+
+    checkpoint_journal(const checkpoint_journal&) = delete;
+    auto operator=(const checkpoint_journal&) -> checkpoint_journal& = delete;
+
+    /// Append the remaining entries and stop the writer.
+    ~checkpoint_journal();
+
+    /// Start a new empty journal, the existing one is discarded.
+    /// @return true if the journal was created
+    auto create() -> bool;
+
+    /// Restore entries from the existing journal into the registry and mark them as done. The journal is kept and
+    /// new batches are appended to it. If there is no journal yet, a new one is created.
+    /// @param registry registry to update
+    /// @return true if the journal was read and can be appended
+    auto resume(entry_registry& registry) -> bool;
+
+    /// @return number of entries restored by resume
+    auto done_count() const -> std::size_t { return m_done.size(); }
+
+    /// @param name decorated entry name
+    /// @return true if the entry was fitted before the resume
+    auto is_done(const std::string& name) const -> bool { return m_done.count(name) != 0; }
+
+    /// Store copy of the fitted entry and schedule append if any trigger is due. The caller holds the entry lock.
+    /// @param name decorated entry name
+    /// @param hfp fitted entry
+    auto record(const std::string& name, const entry& hfp) -> void;
+
+    /// Schedule append of all collected entries.
+    /// @return future result, true if the journal was written
+    auto flush() -> std::shared_future<bool>;
+
+private:
+    /// Append collected entries, called on the writer thread.
+    auto append() -> bool;
+
+    std::string m_filename;
+    std::size_t m_every_fits;
+    clock::duration m_interval;
+
+    // names fitted before the resume, read-only while fitting
+    std::unordered_set<std::string> m_done;
+
+    std::mutex m_mutex;
+    std::vector<std::pair<std::string, entry>> m_records;
+    std::size_t m_fits_since_append {0};
+    clock::time_point m_last_append;
+
+    // last member, so the writer thread is stopped before anything it uses is destroyed
+    async_exporter m_writer;
+};
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_CHECKPOINT_H */
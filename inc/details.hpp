@@ -1,6 +1,17 @@
 #ifndef HELLOFITTY_DETAILS_H
 #define HELLOFITTY_DETAILS_H
 
+#include "alloc_stats.hpp"
+#include "async_export.hpp"
+#include "capture.hpp"
+#include "checkpoint.hpp"
+#include "fit_queue.hpp"
+#include "metrics.hpp"
+#include "patterns.hpp"
+#include "perf_counters.hpp"
+#include "registry.hpp"
+#include "tracing.hpp"
+
 #include <TF1.h>
 #include <TFitResult.h>
 
@@ -8,8 +19,13 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <unordered_map>
+#include <unordered_set>
 
 #if __cplusplus < 201402L
 template<typename T, typename... Args>
@@ -63,16 +79,12 @@ struct draw_opts_impl final
 #endif
 };
 
-/// Structure stores a set of values for a single function parameters like the the mean value,
-/// lwoer or upper boundaries, free or fixed fitting mode.
+/// Single partial function of the formula: its body and the compiled prototype object.
 struct function_impl final
 {
     TF1 function_obj;
     std::string body_string;
 
-    /// Accept param value and fit mode
-    /// @param par_value initial parameter value
-    /// @param par_mode parameter fitting mode, see @ref fit_mode
     explicit function_impl(std::string body, Double_t range_min, Double_t range_max)
         : function_obj {"", body.c_str(), range_min, range_max, TF1::EAddToList::kNo}
         , body_string {std::move(body)}
@@ -87,6 +99,80 @@ struct function_impl final
     }
 };
 
+/// Compiled formula of an entry: partial functions and their sum. It is immutable once built and shared between
+/// copies of the entry, e.g. all entries made from one generic. The TF1 objects are prototypes only, the entries
+/// fit and draw their own instances.
+struct formula_impl final
+{
+    std::vector<function_impl> funcs;
+    std::string complete_function_body;
+    TF1 complete_function_object;
+
+    explicit formula_impl(std::vector<std::string> bodies, Double_t range_min, Double_t range_max)
+    {
+        trace_span span("compile");
+
+        funcs.reserve(bodies.size());
+        for (auto& body : bodies)
+        {
+            funcs.emplace_back(std::move(body), range_min, range_max);
+        }
+
+        complete_function_body = std::accumulate(std::next(funcs.begin()), funcs.end(), funcs[0].body_string,
+                                                 [](std::string a, const hf::detail::function_impl& b)
+                                                 { return std::move(a) + "+" + b.body_string; });
+
+        complete_function_object = TF1("", complete_function_body.c_str(), range_min, range_max, TF1::EAddToList::kNo);
+    }
+
+    auto get_npar() const -> int { return complete_function_object.GetNpar(); }
+};
+
+/// Return the formula of the functions, shared by all entries with the same functions while any of them exists.
+/// @param bodies function bodies
+/// @param range_min range of the prototypes if the formula must be compiled
+/// @param range_max range of the prototypes if the formula must be compiled
+/// @return compiled formula
+auto HELLOFITTY_EXPORT intern_formula(std::vector<std::string> bodies, Double_t range_min, Double_t range_max)
+    -> std::shared_ptr<const formula_impl>;
+
+/// Summarize the accepted fit. The fit result object is only read, so it can be released right after.
+/// @param function fitted function with the new parameters
+/// @param status minimizer status
+/// @param chi2 chi2 of the new parameters in the fit range
+/// @param result fit result, edm and covariance are available only if the fit stored it
+/// @param covariance keep the covariance matrix
+/// @return fit summary
+auto make_fit_summary(const TF1& function, int status, double chi2, const TFitResultPtr& result, bool covariance)
+    -> std::shared_ptr<const fit_summary>;
+
+/// Per-entry TF1 instances made from the shared formula on first use. Copies start empty, so copying an entry
+/// never copies TF1 objects.
+struct function_instances final
+{
+    std::unique_ptr<TF1> complete;
+    std::vector<std::unique_ptr<TF1>> partial;
+
+    function_instances() = default;
+    function_instances(const function_instances& /*other*/) {}
+    function_instances(function_instances&&) = default;
+
+    auto operator=(const function_instances& /*other*/) -> function_instances&
+    {
+        reset();
+        return *this;
+    }
+    auto operator=(function_instances&&) -> function_instances& = default;
+
+    ~function_instances() = default;
+
+    auto reset() -> void
+    {
+        complete.reset();
+        partial.clear();
+    }
+};
+
 struct entry_impl
 {
     Double_t range_min; // function range mix
@@ -95,45 +181,98 @@ struct entry_impl
     int rebin {0}; // rebin, 0 == no rebin
     bool fit_disabled {false};
 
-    std::vector<function_impl> funcs;
-    std::string complete_function_body;
-    TF1 complete_function_object;
+    std::shared_ptr<const formula_impl> formula;
+    std::vector<std::string> pending_bodies; // functions added after the last compile()
+    mutable function_instances instances;
 
-    std::vector<param> pars;
-    std::vector<Double_t> parameters_backup; // backup for parameters
+    std::vector<param> pars;                 // sized exactly to the formula params
+    std::vector<Double_t> parameters_backup; // backup for parameters, allocated by backup() only
 
     std::unordered_map<int, draw_opts> partial_functions_styles;
 
-    entry_impl()
-        : pars(10)
-        , parameters_backup(10)
-    {
-    }
+    std::shared_ptr<const fit_summary> summary; // replaced on each accepted fit, shared by copies
 
     /// Does not recompile the total function. Use compile() after adding last function.
-    auto add_function_lazy(std::string formula) -> int
+    auto add_function_lazy(std::string formula_body) -> int
     {
-        auto current_function_idx = funcs.size();
-        funcs.emplace_back(std::move(formula), range_min, range_max);
-        return size_t2int(current_function_idx);
+        if (pending_bodies.empty())
+        {
+            for (const auto& func : get_functions())
+            {
+                pending_bodies.push_back(func.body_string);
+            }
+        }
+
+        pending_bodies.push_back(std::move(formula_body));
+        return size_t2int(pending_bodies.size() - 1);
     }
 
+    /// Build the new formula from the added functions. The formula shared with other entries is never modified.
     auto compile() -> void
     {
-        if (funcs.size() == 0) { return; }
-        complete_function_body = std::accumulate(std::next(funcs.begin()), funcs.end(), funcs[0].body_string,
-                                                 [](std::string a, hf::detail::function_impl b)
-                                                 { return std::move(a) + "+" + b.body_string; });
+        if (pending_bodies.empty()) { return; }
 
-        complete_function_object = TF1("", complete_function_body.c_str(), range_min, range_max, TF1::EAddToList::kNo);
+        formula = intern_formula(std::move(pending_bodies), range_min, range_max);
+        pending_bodies.clear();
+        instances.reset();
 
-        auto npars = int2size_t(complete_function_object.GetNpar());
+        auto npars = int2size_t(formula->get_npar());
         pars.resize(npars);
-        parameters_backup.resize(npars);
+        pars.shrink_to_fit();
+        if (!parameters_backup.empty())
+        {
+            parameters_backup.resize(npars);
+            parameters_backup.shrink_to_fit();
+        }
+    }
+
+    auto get_functions() const -> const std::vector<function_impl>&
+    {
+        static const std::vector<function_impl> no_functions;
+        return formula ? formula->funcs : no_functions;
+    }
+
+    auto get_npar() const -> int { return formula ? formula->get_npar() : 0; }
+
+    /// Copy the prototype into the entry's own instance, with the entry range and current parameter values.
+    auto materialize(const TF1& prototype) const -> std::unique_ptr<TF1>
+    {
+        auto function = make_unique<TF1>(prototype);
+        function->SetRange(range_min, range_max);
+
+        const auto npars = std::min(int2size_t(function->GetNpar()), pars.size());
+        for (size_t i = 0; i < npars; ++i)
+        {
+            function->SetParameter(size_t2int(i), pars[i].value);
+        }
+        return function;
+    }
+
+    auto get_complete_function() const -> TF1&
+    {
+        if (!instances.complete)
+        {
+            if (formula) { instances.complete = materialize(formula->complete_function_object); }
+            else { instances.complete = make_unique<TF1>(); }
+        }
+        return *instances.complete;
+    }
+
+    auto get_partial_function(size_t function_index) const -> TF1&
+    {
+        const auto& funcs = get_functions();
+        const auto& prototype = funcs.at(function_index).function_obj;
+
+        if (instances.partial.size() != funcs.size()) { instances.partial.resize(funcs.size()); }
+
+        auto& function = instances.partial[function_index];
+        if (!function) { function = materialize(prototype); }
+        return *function;
     }
 
     auto prepare() -> void
     {
+        auto& complete_function_object = get_complete_function();
         auto params_number = int2size_t(complete_function_object.GetNpar());
         for (size_t i = 0; i < params_number; ++i)
         {
@@ -155,6 +294,7 @@ struct entry_impl
     auto backup() -> void
     {
         parameters_backup.clear();
+        parameters_backup.reserve(pars.size());
         for (auto& p : pars)
         {
             parameters_backup.push_back(p.value);
@@ -171,6 +311,13 @@ struct entry_impl
             pars[i].value = parameters_backup[i];
         }
     }
+
+    auto drop() -> void { std::vector<Double_t>().swap(parameters_backup); }
+
+    /// Add memory of the entry to the usage.
+    /// @param usage breakdown to update
+    /// @param formulas formulas counted already, the entry formula is counted only if not there and added
+    auto add_memory_usage(memory_breakdown& usage, std::unordered_set<const formula_impl*>& formulas) const -> void;
 };
 
 struct fitter_impl
@@ -179,23 +326,135 @@ struct fitter_impl
     format_version input_format_version {format_version::detect};
     format_version output_format_version {format_version::v2};
 
-    static bool verbose_flag;
+    std::shared_ptr<logger> log;
     fitter::fit_qa_checker checker {hf::chi2checker()};
+    fitter::fit_qa_summary_checker summary_checker; // used instead of the checker if set
+    fitter::result_mode results {fitter::result_mode::full};
+    std::shared_ptr<fit_observer> observer;
 
     std::string par_ref;
     std::string par_aux;
 
-    std::map<std::string, entry> hfpmap;
+    entry_registry hfpmap;
+    pattern_matcher patterns;
 
     std::string name_decorator {"*"};
     std::string function_decorator {"f_*"};
 
     std::unordered_map<int, draw_opts> partial_functions_styles;
 
+    std::size_t parallel_bins {100000}; // see fitter::set_parallel_threshold()
+
+    bool keep_covariance {false};
+    bool summary_sidecar {false};
+
+    metrics_impl metrics;
+    alloc_counters allocations;
+    std::unique_ptr<perf_monitor> perf; // set only when the counters are enabled
+
+    std::unique_ptr<checkpoint_journal> checkpoint;
+    std::unique_ptr<capture_writer> capture;
+
+    std::mutex export_mutex; // serializes all exports, they share the temporary files
+
+    // last member, so the export thread is stopped before anything it uses is destroyed
+    std::once_flag exporter_once;
+    std::unique_ptr<async_exporter> exporter;
+
+    // destroyed first, the queued fits use everything above. Accessed only through std::atomic_load and
+    // std::atomic_exchange, so a submitter keeps the queue alive while stop_workers() stops it.
+    std::shared_ptr<fit_queue> queue;
+
+    auto get_logger() const -> logger& { return log ? *log : *logger::default_logger(); }
+
+    /// Write snapshot of all entries to the file.
+    /// @param filename output file, replaced at once after the content is written
+    /// @return true if the file was written
+    auto export_parameters(const std::string& filename) -> bool;
+
+    /// Read fit summaries from the sidecar file. Missing file is not an error.
+    /// @param filename sidecar file
+    /// @return pairs of entry name and its fit summary
+    auto read_summaries(const std::string& filename) -> std::vector<std::pair<std::string, fit_summary>>;
+
+    /// Write fit summaries of the fitted entries to the sidecar file. The caller holds export_mutex.
+    /// @param filename sidecar file, replaced at once after the content is written
+    /// @param entries snapshot of the entries
+    /// @return true if the file was written
+    auto export_summaries(const std::string& filename, const std::vector<std::pair<std::string, entry>>& entries)
+        -> bool;
+
+    auto get_exporter() -> async_exporter&
+    {
+        std::call_once(exporter_once,
+                       [this] {
+                           exporter = make_unique<async_exporter>([this](const std::string& filename)
+                                                                  { return export_parameters(filename); });
+                       });
+        return *exporter;
+    }
+
+    /// Old and new parameters report of a single fit, kept as one record so concurrent fits do not interleave.
+    auto log_fit(const char* name, const entry_impl* hfp_m_d, fmt::color old_color, const char* old_label,
+                 const params_vector& old_pars, double old_chi2, fmt::color new_color, const params_vector* new_pars,
+                 double new_chi2, std::string status) const -> void
+    {
+        auto& lg = get_logger();
+        if (!lg.enabled(log_level::info)) { return; }
+
+        log_record record;
+        record.segments.push_back({static_cast<std::uint32_t>(old_color),
+                                   fmt::format("* {:4s} {} ({:g}--{:g}) : {} --> chi2:  {:} -- *", old_label, name,
+                                               hfp_m_d->range_min, hfp_m_d->range_max, old_pars, old_chi2)});
+        if (new_pars)
+        {
+            record.segments.push_back({static_cast<std::uint32_t>(new_color),
+                                       fmt::format("\n* new  {} ({:g}--{:g}) : {} --> chi2:  {:} -- *", name,
+                                                   hfp_m_d->range_min, hfp_m_d->range_max, *new_pars, new_chi2)});
+        }
+        record.segments.push_back({0, fmt::format("\t [ {:s} ]", status)});
+
+        lg.log(std::move(record));
+    }
+
+    auto record_fit(fitter::fit_result result, metrics_impl::clock::time_point start) -> fitter::fit_result
+    {
+        metrics.record_fit(result.status, result.qa, metrics_impl::clock::now() - start);
+        metrics.write_if_due();
+        return result;
+    }
+
+    /// Fit options with the multithreaded execution policy if the fit is large enough.
+    /// @param pars fit options
+    /// @param points number of bins or points in the fit range
+    /// @param storage keeps the extended options
+    /// @return options to use
+    auto parallel_options(const char* pars, std::size_t points, std::string& storage) const -> const char*;
+
+    auto record_rejected() -> fitter::fit_result
+    {
+        metrics.record_fit(fitter::fit_status::rejected, fitter::fit_qa_status::none, {});
+        metrics.write_if_due();
+        return {fitter::fit_status::rejected, nullptr};
+    }
+
+    auto record_missing_entry() -> fitter::fit_result
+    {
+        metrics.record_fit(fitter::fit_status::missing_entry, fitter::fit_qa_status::none, {});
+        metrics.write_if_due();
+        return {fitter::fit_status::missing_entry, nullptr};
+    }
+
     template<class T>
     auto generic_fit(entry* hfp, entry_impl* hfp_m_d, const char* name, T* dataobj, const char* pars,
                      const char* gpars) -> fitter::fit_result
     {
+        trace_span fit_span("generic_fit", name);
+        trace_span phase_span("prepare", name);
+
+        auto* obs = observer.get();
+        if (obs) { obs->before_prepare(name, *hfp); }
+
         hfp_m_d->prepare();
 
         TF1* tfSum = &hfp->get_function_object();
@@ -210,6 +469,7 @@ struct fitter_impl
             backup_old[int2size_t(i)] = hfp->get_param(i);
         }
 
+        phase_span.next("chi2_before");
         double chi2_backup_old = dataobj->Chisquare(tfSum, "R");
 
         if (!apply_style(tfSum, hfp_m_d->partial_functions_styles, -1))
@@ -220,9 +480,22 @@ struct fitter_impl
             }
         }
 
+        phase_span.next("minimize");
+        if (obs) { obs->before_minimize(name, *hfp); }
+
+        const auto counting = perf and perf_monitor::start();
         auto fit_res = dataobj->Fit(tfSum, pars, gpars, hfp->get_fit_range_min(), hfp->get_fit_range_max());
+        if (counting)
+        {
+            // entries without functions have no formula, the fit fails but is still counted
+            perf->record(name, hfp_m_d->formula ? hfp_m_d->formula->complete_function_body : std::string(),
+                         perf_monitor::stop());
+        }
 
         auto fit_status = fit_res.Get() ? fit_res->Status() : int(fit_res);
+        if (obs) { obs->after_minimize(name, *hfp, fit_status); }
+
+        phase_span.next("chi2_after");
 
         // backup new parameters
         params_vector backup_new = backup_old;
@@ -233,66 +506,56 @@ struct fitter_impl
 
         double chi2_backup_new = dataobj->Chisquare(tfSum, "R");
 
+        // the summary holds all what is needed of the fit result, in compact mode it is released after the QA
+        auto summary = make_fit_summary(*tfSum, fit_status, chi2_backup_new, fit_res, keep_covariance);
+        const auto compact = results == fitter::result_mode::compact;
+
         if (fit_status != 0)
         {
-            if (verbose_flag)
-            {
-                fmt::print(fmt::fg(fmt::color::red), "* old  {} ({:g}--{:g}) : {} --> chi2:  {:} -- *\n", name,
-                           hfp_m_d->range_min, hfp_m_d->range_max, backup_old, chi2_backup_old);
-                fmt::print(fmt::fg(fmt::color::red), "* new  {} ({:g}--{:g}) : {} --> chi2:  {:} -- *", name,
-                           hfp_m_d->range_min, hfp_m_d->range_max, backup_new, chi2_backup_new);
-                fmt::print("\t [ invalid, error code: {:d} ]\n", fit_status);
-            }
+            log_fit(name, hfp_m_d, fmt::color::red, "old", backup_old, chi2_backup_old, fmt::color::red, &backup_new,
+                    chi2_backup_new, fmt::format("invalid, error code: {:d}", fit_status));
 
             for (int i = 0; i < par_num; ++i)
             {
                 tfSum->SetParameter(i, backup_old[int2size_t(i)].value);
             }
+            if (obs) { obs->on_restore(name, *hfp); }
+            if (compact) { fit_res = TFitResultPtr(fit_status); }
 
-            return {fitter::fit_status::failed, hfp, fitter::fit_qa_status::none, fit_res};
+            return {fitter::fit_status::failed, hfp, fitter::fit_qa_status::none, fit_res, std::move(summary)};
         }
 
-        auto qa_status = checker(backup_old, chi2_backup_old, backup_new, chi2_backup_new, fit_res);
+        phase_span.next("qa");
+        auto qa_status = summary_checker
+                             ? summary_checker(backup_old, chi2_backup_old, backup_new, chi2_backup_new, *summary)
+                             : checker(backup_old, chi2_backup_old, backup_new, chi2_backup_new, fit_res);
+        if (compact) { fit_res = TFitResultPtr(fit_status); }
+        if (obs) { obs->on_qa(name, *hfp, qa_status, *summary); }
 
         switch (qa_status)
         {
             case fitter::fit_qa_status::chi2_better:
 
-                if (verbose_flag)
-                {
-                    fmt::print(fmt::fg(fmt::color::royal_blue), "* old  {} ({:g}--{:g}) : {} --> chi2:  {:} -- *\n",
-                               name, hfp_m_d->range_min, hfp_m_d->range_max, backup_old, chi2_backup_old);
-                    fmt::print(fmt::fg(fmt::color::lime_green), "* new  {} ({:g}--{:g}) : {} --> chi2:  {:} -- *", name,
-                               hfp_m_d->range_min, hfp_m_d->range_max, backup_new, chi2_backup_new);
-                    fmt::print("\t [ OK ]\n");
-                }
+                log_fit(name, hfp_m_d, fmt::color::royal_blue, "old", backup_old, chi2_backup_old,
+                        fmt::color::lime_green, &backup_new, chi2_backup_new, "OK");
                 break;
 
             case fitter::fit_qa_status::chi2_same:
 
-                if (verbose_flag)
-                {
-                    fmt::print(fmt::fg(fmt::color::orange), "* fine {} ({:g}--{:g}) : {} --> chi2:  {:} -- *", name,
-                               hfp_m_d->range_min, hfp_m_d->range_max, backup_old, chi2_backup_new);
-                    fmt::print("\t [ PASS ]\n");
-                }
+                log_fit(name, hfp_m_d, fmt::color::orange, "fine", backup_old, chi2_backup_new, fmt::color::orange,
+                        nullptr, 0.0, "PASS");
                 break;
 
             case fitter::fit_qa_status::chi2_worse:
 
-                if (verbose_flag)
-                {
-                    fmt::print(fmt::fg(fmt::color::royal_blue), "* old  {} ({:g}--{:g}) : {} --> chi2:  {:} -- *\n",
-                               name, hfp_m_d->range_min, hfp_m_d->range_max, backup_old, chi2_backup_old);
-                    fmt::print(fmt::fg(fmt::color::yellow), "* new  {} ({:g}--{:g}) : {} --> chi2:  {:} -- *", name,
-                               hfp_m_d->range_min, hfp_m_d->range_max, backup_new, chi2_backup_new);
-                    fmt::print("\t [ WORSE - restoring old params ]\n");
-                }
+                log_fit(name, hfp_m_d, fmt::color::royal_blue, "old", backup_old, chi2_backup_old, fmt::color::yellow,
+                        &backup_new, chi2_backup_new, "WORSE - restoring old params");
 
                 for (int i = 0; i < par_num; ++i)
                 {
                     tfSum->SetParameter(i, backup_old[int2size_t(i)].value);
                 }
+                if (obs) { obs->on_restore(name, *hfp); }
 
                 break;
 
@@ -300,8 +563,12 @@ struct fitter_impl
                 break;
         }
 
+        phase_span.next("update");
         tfSum->SetChisquare(dataobj->Chisquare(tfSum, "R"));
 
+        // restored parameters keep the summary of the fit they come from
+        if (qa_status != fitter::fit_qa_status::chi2_worse) { hfp_m_d->summary = summary; }
+
         const auto functions_count = hfp->get_functions_count();
 
         for (auto i = 0; i < par_num; ++i)
@@ -324,6 +591,7 @@ struct fitter_impl
 
         if (functions_count > 1)
         {
+            phase_span.next("partial_functions");
             for (auto i = 0; i < functions_count; ++i)
             {
                 auto& partial_function = hfp->get_function_object(i);
@@ -340,7 +608,7 @@ struct fitter_impl
             }
         }
 
-        return {fitter::fit_status::ok, hfp, qa_status, fit_res};
+        return {fitter::fit_status::ok, hfp, qa_status, fit_res, std::move(summary)};
     }
 };
 
@@ -0,0 +1,82 @@
+#ifndef HELLOFITTY_FIT_QUEUE_H
+#define HELLOFITTY_FIT_QUEUE_H
+
+#include "hellofitty.hpp"
+
+#include "affinity.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hf::detail
+{
+
+/// Histogram fit waiting for a worker. The result goes to the callback if set, otherwise to the promise.
+struct queued_fit
+{
+    TH1* hist {nullptr};
+    std::string pars;
+    std::string gpars;
+    std::promise<fitter::fit_result> promise;
+    fitter::fit_callback callback;
+};
+
+/// Bounded queue of submitted fits served by a pool of worker threads.
+class fit_queue final
+{
+public:
+    using fit_function = std::function<fitter::fit_result(TH1*, const char*, const char*)>;
+
+    /// @param function runs a single fit
+    /// @param bindings CPUs of each worker thread, one thread is started per binding
+    /// @param capacity maximal number of waiting fits
+    /// @param policy behaviour of push() when the queue is full
+    fit_queue(fit_function function, std::vector<cpu_binding> bindings, std::size_t capacity,
+              fitter::submit_policy policy);
+
+    fit_queue(const fit_queue&) = delete;
+    auto operator=(const fit_queue&) -> fit_queue& = delete;
+
+    /// Stop the workers, see stop().
+    ~fit_queue();
+
+    /// Finish all waiting fits and stop the workers. Later pushes, and pushes waiting for a free slot, are rejected.
+    /// Called by a single thread, not by a worker.
+    auto stop() -> void;
+
+    /// Queue the fit, or wait for a free slot with submit_policy::block.
+    /// @param job the fit, left untouched if not queued
+    /// @return false if the queue is full with submit_policy::fail_fast, or the queue is stopping
+    auto push(queued_fit& job) -> bool;
+
+    /// @return number of fits waiting for a worker
+    auto pending() const -> std::size_t;
+
+    /// @return description of the CPUs each worker is pinned to
+    auto bindings() const -> std::vector<std::string>;
+
+private:
+    auto run() -> void;
+
+    fit_function m_function;
+    std::size_t m_capacity;
+    fitter::submit_policy m_policy;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    std::deque<queued_fit> m_jobs;
+    std::vector<std::string> m_bindings;
+    bool m_stop {false};
+    std::vector<std::thread> m_threads;
+};
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_FIT_QUEUE_H */
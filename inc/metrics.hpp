@@ -0,0 +1,69 @@
+#ifndef HELLOFITTY_METRICS_H
+#define HELLOFITTY_METRICS_H
+
+#include "hellofitty.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace hf::detail
+{
+
+/// Upper bounds (in seconds) of the fit time histogram buckets, the +Inf bucket is implicit.
+constexpr std::array<double, 10> fit_seconds_bounds {1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2, 1e-1, 5e-1, 1.0, 5.0};
+
+/// Number of values in fitter::fit_status and fitter::fit_qa_status.
+constexpr std::size_t fit_status_count = 7;
+constexpr std::size_t fit_qa_status_count = 4;
+
+/// Lock-free counters of the fitter activity and the optional periodic file sink.
+struct metrics_impl
+{
+    using clock = std::chrono::steady_clock;
+    using counter = std::atomic<std::uint64_t>;
+
+    clock::time_point start_time {clock::now()};
+
+    counter fits_attempted {0};
+    std::array<counter, fit_status_count> fit_status_counts {};
+    std::array<counter, fit_qa_status_count> fit_qa_counts {};
+    std::array<counter, fit_seconds_bounds.size() + 1> fit_time_counts {};
+    counter fit_time_ns {0};
+
+    counter imports {0};
+    counter import_entries {0};
+    counter import_time_ns {0};
+    counter exports {0};
+    counter export_entries {0};
+    counter export_time_ns {0};
+
+    // file settings are guarded by the write mutex, enabled lets the fits skip it when no file is set
+    std::string filename;
+    fitter::metrics_format format {fitter::metrics_format::json};
+    clock::duration interval {std::chrono::seconds(10)};
+    clock::time_point last_write {};
+    mutable std::mutex write_mutex;
+    std::atomic<bool> enabled {false};
+
+    auto record_fit(fitter::fit_status status, fitter::fit_qa_status qa, clock::duration elapsed) -> void;
+    auto record_import(std::size_t entries, clock::duration elapsed) -> void;
+    auto record_export(std::size_t entries, clock::duration elapsed) -> void;
+
+    auto snapshot() const -> fitter::statistics;
+
+    /// Write the metrics file unconditionally, the caller holds the write mutex.
+    auto write() const -> bool;
+    /// Write the metrics file if the interval elapsed since the last write.
+    auto write_if_due() -> void;
+};
+
+auto format_metrics_json(const fitter::statistics& stats) -> std::string;
+auto format_metrics_prometheus(const fitter::statistics& stats) -> std::string;
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_METRICS_H */
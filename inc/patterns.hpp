@@ -0,0 +1,71 @@
+#ifndef HELLOFITTY_PATTERNS_H
+#define HELLOFITTY_PATTERNS_H
+
+#include "hellofitty.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hf::detail
+{
+
+/// Pattern entries serving as generics for the names they match. Patterns are indexed in a trie by their literal
+/// prefix (up to the first wildcard), so a lookup walks the name once and tests only the patterns whose prefix the
+/// name starts with. The most specific pattern wins: the longest literal prefix, then the first inserted.
+class pattern_matcher final
+{
+public:
+    /// Add the pattern, or replace the entry of an existing one.
+    /// @param pattern glob pattern, see tools::glob_match()
+    /// @param hfp entry used for the matching names
+    auto insert(std::string pattern, entry hfp) -> void;
+
+    /// Call the visitor with the entry of the most specific pattern matching the name. The entry must not be
+    /// kept after the visitor returns.
+    /// @param name tested name
+    /// @param visitor called as visitor(const std::string& pattern, const entry& hfp)
+    /// @return true if a pattern matched
+    template<class Visitor> auto match(const std::string& name, Visitor&& visitor) const -> bool
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+        const auto* found = find(name);
+        if (!found) { return false; }
+
+        visitor(found->first, *found->second);
+        return true;
+    }
+
+    auto clear() -> void;
+
+    auto size() const -> std::size_t;
+
+    /// Copy of all patterns in the insertion order.
+    /// @return pairs of pattern and entry
+    auto snapshot() const -> std::vector<std::pair<std::string, entry>>;
+
+private:
+    using pattern_item = std::pair<std::string, std::unique_ptr<entry>>;
+
+    struct node
+    {
+        std::map<char, std::unique_ptr<node>> children;
+        std::vector<std::size_t> patterns; // indices of patterns with the literal prefix ending here
+    };
+
+    /// The caller holds the lock.
+    auto find(const std::string& name) const -> const pattern_item*;
+
+    mutable std::shared_mutex m_mutex;
+    node m_root;
+    std::vector<pattern_item> m_patterns; // entries are kept by pointer, so they never move
+};
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_PATTERNS_H */
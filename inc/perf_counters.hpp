@@ -0,0 +1,62 @@
+#ifndef HELLOFITTY_PERF_COUNTERS_H
+#define HELLOFITTY_PERF_COUNTERS_H
+
+#include "hellofitty.hpp"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hf::detail
+{
+
+/// Hardware counters of a single measured interval.
+struct perf_sample
+{
+    std::uint64_t cycles {0};
+    std::uint64_t instructions {0};
+    std::uint64_t cache_misses {0};
+    std::uint64_t branch_misses {0};
+};
+
+/// Counts cycles, instructions, cache and branch misses of the minimization with perf_event_open, and sums them per
+/// entry and per formula. Each fitting thread opens own counter group on its first measured fit, user space only.
+/// Counters which the kernel or the container does not allow stay zero; if none can be opened, the fits are not
+/// measured. On systems other than Linux the counters are never available.
+class perf_monitor final
+{
+public:
+    /// Check whether the counters can be opened on the calling thread.
+    /// @return true if at least the cycles counter is available
+    static auto available() -> bool;
+
+    /// Reset and enable the counters of the calling thread.
+    /// @return false if the counters of this thread can't be opened
+    static auto start() -> bool;
+
+    /// Disable and read the counters of the calling thread, started with start().
+    /// @return the counts since start()
+    static auto stop() -> perf_sample;
+
+    /// Add the sample to the totals.
+    /// @param name entry (histogram) name
+    /// @param formula complete function body of the entry
+    /// @param sample measured counts
+    auto record(const char* name, const std::string& formula, const perf_sample& sample) -> void;
+
+    /// @return totals per entry, sorted by name
+    auto by_entry() const -> std::vector<std::pair<std::string, perf_counts>>;
+    /// @return totals per formula, sorted by formula body
+    auto by_formula() const -> std::vector<std::pair<std::string, perf_counts>>;
+
+private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, perf_counts> m_entries;
+    std::unordered_map<std::string, perf_counts> m_formulas;
+};
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_PERF_COUNTERS_H */
@@ -0,0 +1,99 @@
+#ifndef HELLOFITTY_REGISTRY_H
+#define HELLOFITTY_REGISTRY_H
+
+#include "hellofitty.hpp"
+
+#include <array>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hf::detail
+{
+
+/// Mutex guarding the entry contents during fit, overwrite and snapshot copy. Mutexes are striped by the entry
+/// address, so entries do not carry own mutex and stay cheap to copy.
+auto HELLOFITTY_EXPORT entry_mutex(const entry* hfp) -> std::mutex&;
+
+/// Entry registry safe for concurrent lookup and insertion. Names are spread over shards by hash, each shard is an
+/// ordered map guarded by its own shared mutex. Map nodes never move, so returned entry pointers stay valid until
+/// the registry is cleared.
+class entry_registry final
+{
+public:
+    static constexpr std::size_t shard_count = 64;
+
+    /// Find entry by name.
+    /// @param name entry name
+    /// @return entry or nullptr
+    auto find(const std::string& name) const -> entry*;
+
+    /// Insert the entry, or replace the existing one with the same name. A running fit of the replaced entry is
+    /// finished first.
+    /// @param name entry name
+    /// @param hfp entry
+    /// @return registered entry
+    auto insert_or_assign(std::string name, entry hfp) -> entry*;
+
+    /// Insert copy of the generic if there is no entry of the name yet. Concurrent calls for the same name insert it
+    /// once and return the same entry.
+    /// @param name entry name
+    /// @param generic entry to copy
+    /// @return pair of the registered entry and whether it was inserted by this call
+    auto find_or_insert(const std::string& name, const entry& generic) -> std::pair<entry*, bool>;
+
+    auto clear() -> void;
+
+    auto size() const -> std::size_t;
+
+    /// Copy of all entries sorted by name. The set of entries is taken with all shards locked, then each entry is
+    /// copied under its mutex after the shard locks are released, so fits and lookups are not blocked meanwhile.
+    /// @return name and entry pairs
+    auto snapshot() const -> std::vector<std::pair<std::string, entry>>;
+
+    /// Entries with names starting with the prefix, found by range lookup in each shard, so the cost grows with the
+    /// number of matches and not with the registry size.
+    /// @param prefix name prefix, empty selects all entries
+    /// @param filter optional further condition on the name
+    /// @return name and entry pairs sorted by name
+    auto select(const std::string& prefix, const std::function<bool(const std::string&)>& filter = {}) const
+        -> std::vector<std::pair<std::string, entry*>>;
+
+    /// Visit all entries, unsorted. The entries are collected with all shards locked for reading and visited after
+    /// the locks are released, so the visitor may take the entry mutex. Entries inserted meanwhile are not visited.
+    /// @param visitor callable accepting name and entry
+    template<class Visitor> auto for_each(Visitor&& visitor) const -> void
+    {
+        for (const auto* item : items())
+        {
+            visitor(item->first, item->second);
+        }
+    }
+
+private:
+    struct alignas(64) shard
+    {
+        mutable std::shared_mutex mutex;
+        std::map<std::string, entry> entries;
+    };
+
+    auto shard_of(const std::string& name) -> shard&;
+    auto shard_of(const std::string& name) const -> const shard&;
+
+    /// Shared locks of all shards, always taken in the same order.
+    auto lock_all() const -> std::vector<std::shared_lock<std::shared_mutex>>;
+
+    /// Pointers to all name and entry pairs, collected with all shards locked. Map nodes never move, so they stay
+    /// valid after the locks are released, until the registry is cleared.
+    auto items() const -> std::vector<const std::map<std::string, entry>::value_type*>;
+
+    std::array<shard, shard_count> m_shards;
+};
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_REGISTRY_H */
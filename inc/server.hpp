@@ -0,0 +1,122 @@
+#ifndef HELLOFITTY_SERVER_IMPL_H
+#define HELLOFITTY_SERVER_IMPL_H
+
+#include "hellofitty_server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hf::detail
+{
+
+/// Buffered line reading and writing over a connected socket.
+class socket_stream final
+{
+public:
+    explicit socket_stream(int fd)
+        : m_fd(fd)
+    {
+    }
+
+    /// Read the next line without the newline.
+    /// @param line output line
+    /// @return false if the connection is closed before a complete line
+    auto read_line(std::string& line) -> bool;
+
+    /// Write all data.
+    /// @param data data to write
+    /// @return false if the connection is closed
+    auto write(const std::string& data) -> bool;
+
+private:
+    int m_fd;
+    std::string m_buffer;
+};
+
+struct fit_job
+{
+    std::string name;
+    int bins {0};
+    double xmin {0.0};
+    double xmax {0.0};
+    std::vector<double> contents;
+    std::promise<std::string> reply;
+};
+
+struct client_connection
+{
+    int fd {-1};
+    std::thread thread;
+    std::atomic<bool> done {false};
+};
+
+struct server_impl
+{
+    using clock = std::chrono::steady_clock;
+
+    server_impl(fitter& f, server::options o)
+        : hfitter(f)
+        , opts(std::move(o))
+    {
+    }
+
+    fitter& hfitter;
+    server::options opts;
+
+    int listen_fd {-1};
+    std::atomic<bool> stopping {false};
+    std::atomic<std::uint64_t> fits_since_export {0};
+
+    // waiting fits, interactive ones are always taken first
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_cv;
+    std::deque<std::unique_ptr<fit_job>> interactive_jobs;
+    std::deque<std::unique_ptr<fit_job>> batch_jobs;
+    bool workers_stop {false};
+
+    std::mutex clients_mutex;
+    std::list<std::unique_ptr<client_connection>> clients;
+
+    std::thread acceptor;
+    std::vector<std::thread> workers;
+
+    std::mutex state_mutex;
+    std::condition_variable state_cv;
+    bool running {false};
+
+    auto accept_loop() -> void;
+    auto serve_client(client_connection& connection) -> void;
+    auto work() -> void;
+
+    /// Join and close finished client connections, or all of them when stopping.
+    auto reap_clients(bool all) -> void;
+
+    /// Parse the fit request and wait for a worker to run it.
+    auto request_fit(std::istringstream& request) -> std::string;
+    auto run_fit(const fit_job& job) -> std::string;
+    auto get_entry(const std::string& name) -> std::string;
+};
+
+struct client_impl
+{
+    int fd {-1};
+    std::unique_ptr<socket_stream> stream;
+
+    /// Send the request and return the first reply line after "ok".
+    auto call(const std::string& request) -> std::string;
+};
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_SERVER_IMPL_H */
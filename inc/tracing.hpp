@@ -0,0 +1,63 @@
+#ifndef HELLOFITTY_TRACING_H
+#define HELLOFITTY_TRACING_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace hf::detail
+{
+
+/// Set by tools::start_tracing(), the only thing checked by the disabled span.
+extern std::atomic<bool> tracing_enabled;
+
+using trace_clock = std::chrono::steady_clock;
+
+auto record_trace_event(const char* name, std::string arg, trace_clock::time_point begin,
+                        trace_clock::time_point end) -> void;
+
+/// RAII span emitted as a Chrome trace "complete" event. The name must be a string literal, the optional argument
+/// is copied only when tracing is enabled.
+class trace_span final
+{
+public:
+    explicit trace_span(const char* name, const char* arg = nullptr)
+    {
+        if (tracing_enabled.load(std::memory_order_relaxed))
+        {
+            m_name = name;
+            if (arg) { m_arg = arg; }
+            m_begin = trace_clock::now();
+        }
+    }
+
+    trace_span(const trace_span&) = delete;
+    auto operator=(const trace_span&) -> trace_span& = delete;
+
+    ~trace_span()
+    {
+        if (m_name) { record_trace_event(m_name, std::move(m_arg), m_begin, trace_clock::now()); }
+    }
+
+    /// Close current span and open the next one with the same argument, used for consecutive phases.
+    /// @param name name of the next span, must be a string literal
+    auto next(const char* name) -> void
+    {
+        if (m_name)
+        {
+            const auto now = trace_clock::now();
+            record_trace_event(m_name, m_arg, m_begin, now);
+            m_name = name;
+            m_begin = now;
+        }
+    }
+
+private:
+    const char* m_name {nullptr};
+    std::string m_arg;
+    trace_clock::time_point m_begin;
+};
+
+} // namespace hf::detail
+
+#endif /* HELLOFITTY_TRACING_H */
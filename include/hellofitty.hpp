@@ -24,11 +24,14 @@
 #include <RtypesCore.h>
 #include <TFitResultPtr.h>
 
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #if __cplusplus < 201402L
 #    define CONSTEXPR
@@ -76,6 +79,7 @@ namespace detail
 struct draw_opts_impl;
 struct entry_impl;
 struct fitter_impl;
+struct logger_impl;
 } // namespace detail
 
 class HELLOFITTY_EXPORT draw_opts final
@@ -115,19 +119,20 @@ private:
 struct param final
 {
     /// Fitting mode.
-    enum class fit_mode
+    enum class fit_mode : std::uint8_t
     {
         free, ///< parameter is free for fitting
         fixed ///< parameter is fixed
     };
 
-    Double_t value {0.0};           ///< param value
-    Double_t min {0.0};             ///< lower limit
-    Double_t max {0.0};             ///< upper limit
-    fit_mode mode {fit_mode::free}; ///< Parameter fitting mode
-    bool has_limits {false};        ///< Remembers whether hit limits were set
-    int print_precision {8};        ///< Screen print precision
-    int store_precision {8};        ///< File export precision
+    Double_t value {0.0};             ///< param value
+    Double_t min {0.0};               ///< lower limit
+    Double_t max {0.0};               ///< upper limit
+    fit_mode mode {fit_mode::free};   ///< Parameter fitting mode
+    bool has_limits {false};          ///< Remembers whether hit limits were set
+    // single bytes keep the param at 32 bytes, the precisions were int before
+    std::uint8_t print_precision {8}; ///< Screen print precision
+    std::uint8_t store_precision {8}; ///< File export precision
 
     constexpr param() = default;
 
@@ -158,7 +163,114 @@ struct param final
     auto print() const -> void;
 };
 
+/// Severity of the log message.
+enum class log_level
+{
+    debug,   ///< detailed diagnostics
+    info,    ///< fit progress, the default verbose output
+    warning, ///< recoverable problems
+    error,   ///< failed operations
+    off      ///< nothing is logged
+};
+
+/// Single log message. The message consists of segments, each with own color, so that one record can hold the
+/// complete multi-line fit report without being interleaved with records from other threads.
+struct log_record
+{
+    /// Part of the message with common color.
+    struct segment
+    {
+        std::uint32_t color {0}; ///< RGB color, 0 for default terminal color
+        std::string text;        ///< segment text
+    };
+
+    log_level level {log_level::info}; ///< message severity
+    std::vector<segment> segments;     ///< message content
+};
+
+/// Converts the record to the output text.
+using log_formatter = std::function<std::string(const log_record&)>;
+
+/// Formatter reproducing colored terminal output of the fitter.
+auto HELLOFITTY_EXPORT colored_formatter(const log_record& record) -> std::string;
+/// Formatter without colors, prefixed with the severity.
+auto HELLOFITTY_EXPORT plain_formatter(const log_record& record) -> std::string;
+
+/// Destination of the log messages. The sink is called only from the logger background thread.
+class HELLOFITTY_EXPORT log_sink
+{
+public:
+    virtual ~log_sink() = default;
+    /// Write single record.
+    /// @param record the log record
+    virtual auto write(const log_record& record) -> void = 0;
+    /// Flush buffered output.
+    virtual auto flush() -> void {}
+};
+
+/// Create sink writing to the terminal, errors go to stderr.
+/// @param formatter record formatter
+/// @return the sink
+auto HELLOFITTY_EXPORT make_console_sink(log_formatter formatter = colored_formatter) -> std::shared_ptr<log_sink>;
+/// Create sink appending to the file.
+/// @param filename output file
+/// @param formatter record formatter
+/// @return the sink
+auto HELLOFITTY_EXPORT make_file_sink(const std::string& filename, log_formatter formatter = plain_formatter)
+    -> std::shared_ptr<log_sink>;
+/// Create sink discarding all messages.
+/// @return the sink
+auto HELLOFITTY_EXPORT make_null_sink() -> std::shared_ptr<log_sink>;
+
+/// Asynchronous logger. Each producing thread writes to own lock-free ring buffer, which are drained by a background
+/// thread passing the records to the sink. When the ring buffer is full, the records are dropped rather than blocking
+/// the fitting.
+class HELLOFITTY_EXPORT logger final
+{
+public:
+    /// @param sink destination of the records
+    /// @param level minimal level of logged records
+    /// @param ring_capacity capacity of the per-thread ring buffer, rounded up to power of two
+    explicit logger(std::shared_ptr<log_sink> sink, log_level level = log_level::info,
+                    std::size_t ring_capacity = 1024);
+
+    logger(const logger&) = delete;
+    auto operator=(const logger&) -> logger& = delete;
+
+    /// Writes all pending records and stops the background thread.
+    ~logger();
+
+    auto set_level(log_level level) -> void;
+    auto get_level() const -> log_level;
+
+    /// Check whether record of given level would be logged, use it to avoid formatting of ignored messages.
+    /// @param level record level
+    /// @return true if record would be logged
+    auto enabled(log_level level) const -> bool;
+
+    /// Queue the record. Does not block.
+    /// @param record record to log
+    auto log(log_record record) -> void;
+    /// Queue single-segment record.
+    /// @param level record level
+    /// @param text message
+    auto log(log_level level, std::string text) -> void;
+
+    /// Block until all records queued so far are written.
+    auto flush() -> void;
+
+    /// Number of records dropped due to full ring buffers.
+    auto dropped() const -> std::uint64_t;
+
+    /// Process-wide console logger used by fitters without own logger.
+    static auto default_logger() -> const std::shared_ptr<logger>&;
+
+private:
+    std::shared_ptr<detail::logger_impl> m_d;
+};
+
 class fitter;
+class fit_observer;
 
 namespace parser
 {
@@ -166,6 +278,89 @@ struct v1;
 struct v2;
 } // namespace parser
 
+/// Estimated memory of the fitter or an entry in bytes, by owner. Allocator overhead is not included, ROOT objects
+/// are approximated by their size and parameter arrays.
+struct memory_breakdown
+{
+    std::size_t registry {0};    ///< registry nodes and name keys
+    std::size_t entries {0};     ///< entry objects, without the parts below
+    std::size_t params {0};      ///< param storage
+    std::size_t backups {0};     ///< backup storage
+    std::size_t functions {0};   ///< compiled formulas (shared ones counted once) and function instances
+    std::size_t styles {0};      ///< draw styles
+    std::size_t fit_results {0}; ///< fit results kept by the entries
+
+    auto total() const -> std::size_t
+    {
+        return registry + entries + params + backups + functions + styles + fit_results;
+    }
+};
+
+/// Outcome of the last accepted fit of an entry, kept after the fit result object is released.
+struct HELLOFITTY_EXPORT fit_summary
+{
+    int status {0};                 ///< minimizer status, 0 for a successful fit
+    double chi2 {0.0};              ///< chi2 of the fit in the fit range
+    int ndf {0};                    ///< number of degrees of freedom
+    double edm {0.0};               ///< estimated distance to minimum, 0 if the fit result was not stored
+    std::vector<double> params;     ///< parameter values found by the fit
+    std::vector<double> errors;     ///< parameter errors
+    std::vector<double> covariance; ///< packed lower triangle of the covariance matrix, empty if not kept
+
+    auto chi2_ndf() const -> double { return ndf > 0 ? chi2 / ndf : 0.0; }
+
+    /// Covariance of two parameters.
+    /// @param i first parameter index
+    /// @param j second parameter index
+    /// @return covariance, or 0 if the covariance matrix was not kept
+    auto get_covariance(std::size_t i, std::size_t j) const -> double;
+};
+
+/// Parameters of many entries in contiguous arrays, one element per parameter, and per-entry arrays for names and
+/// fit status. Parameters of entry i are at indices offsets[i] to offsets[i + 1]. The object can be reused between
+/// calls to keep its allocations.
+struct param_columns
+{
+    std::vector<std::string> names;       ///< entry names
+    std::vector<std::size_t> offsets;     ///< first parameter index of each entry, with the total at the end
+    std::vector<int> status;              ///< status of the last accepted fit, -1 if there is no fit summary
+    std::vector<double> values;           ///< parameter values
+    std::vector<double> errors;           ///< parameter errors from the fit summary, 0 if there is none
+    std::vector<double> min;              ///< lower limits
+    std::vector<double> max;              ///< upper limits
+    std::vector<std::uint8_t> has_limits; ///< 1 if the limits are applied in the fit, 0 if min and max are ignored
+    std::vector<param::fit_mode> modes;   ///< fitting modes
+
+    auto entries_count() const -> std::size_t { return names.size(); }
+    auto params_count() const -> std::size_t { return values.size(); }
+};
+
+/// Hardware counters summed over the minimizations of many fits, see fitter::set_perf_counters().
+struct perf_counts
+{
+    std::uint64_t fits {0};          ///< number of measured fits
+    std::uint64_t cycles {0};        ///< CPU cycles
+    std::uint64_t instructions {0};  ///< retired instructions
+    std::uint64_t cache_misses {0};  ///< last level cache misses
+    std::uint64_t branch_misses {0}; ///< mispredicted branches
+
+    auto ipc() const -> double
+    {
+        return cycles ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0.0;
+    }
+};
+
+/// Inputs of a single histogram fit read from the capture file, see fitter::start_capture().
+struct captured_fit
+{
+    std::string name;             ///< histogram name
+    std::string options;          ///< fit options
+    std::string entry_line;       ///< entry before the fit, in the v2 format
+    std::vector<double> edges;    ///< bin edges of the fit range, one more than the bins
+    std::vector<double> contents; ///< bin contents
+    std::vector<double> errors;   ///< bin errors
+};
+
 /// Stores full description of a single fit entry - signal and background functions, and parameters.
 class HELLOFITTY_EXPORT entry final
 {
@@ -277,6 +472,14 @@ public:
 
     auto print(const std::string& name, bool detailed = false) const -> void;
 
+    /// Summary of the last accepted fit, or of the imported one if the summary sidecar is enabled in the fitter.
+    /// @return fit summary or nullptr if the entry was not fitted
+    auto get_fit_summary() const -> const fit_summary*;
+
+    /// Estimate memory used by the entry, including its compiled formula even if shared.
+    /// @return memory breakdown
+    auto memory_usage() const -> memory_breakdown;
+
     friend hf::fitter;
     friend hf::parser::v1;
     friend hf::parser::v2;
@@ -305,6 +508,25 @@ public:
         newer
     };
 
+    /// Pattern kind of select().
+    enum class match_mode
+    {
+        prefix, ///< names starting with the pattern
+        glob,   ///< wildcards '*' for any sequence and '?' for any character
+        regex   ///< ECMAScript regular expression matching the whole name
+    };
+
+    /// Entries chosen by select(), sorted by name. The pointers stay valid until the fitter is cleared or the
+    /// parameters are imported again.
+    using selection = std::vector<std::pair<std::string, entry*>>;
+
+    /// Handling of the existing checkpoint journal.
+    enum class checkpoint_mode
+    {
+        fresh, ///< discard the journal and start a new one
+        resume ///< restore entries from the journal and skip their fits
+    };
+
     enum class fit_status
     {
         ok,
@@ -312,6 +534,8 @@ public:
         empty_range,
         failed,
         qa_worse_chi2,
+        skipped,  ///< already fitted according to the resumed checkpoint
+        rejected, ///< not submitted, the queue was full with submit_policy::fail_fast or the workers were stopping
     };
 
     enum class fit_qa_status
@@ -322,19 +546,101 @@ public:
         chi2_worse,
     };
 
+    /// What the fit_result keeps of the ROOT fit result.
+    enum class result_mode
+    {
+        full,   ///< the TFitResultPtr as returned by the fit
+        compact ///< only the fit summary, the TFitResult is released right after the QA
+    };
+
     using fit_qa_checker = std::function<hf::fitter::fit_qa_status(const params_vector&, double, const params_vector&,
                                                                    double, const TFitResultPtr&)>;
+    using fit_qa_summary_checker = std::function<hf::fitter::fit_qa_status(
+        const params_vector&, double, const params_vector&, double, const fit_summary&)>;
 
     struct fit_result
     {
         fit_status status;
         entry* hfp {nullptr};
         fit_qa_status qa {fit_qa_status::none};
-        TFitResultPtr result;
+        TFitResultPtr result;                       ///< holds only the status in the compact mode
+        std::shared_ptr<const fit_summary> summary; ///< summary of this fit, null if the fit did not run
 
         operator bool() const { return status == fit_status::ok; }
     };
 
+    /// Receives the result of a submitted fit, called on the worker thread.
+    using fit_callback = std::function<void(fit_result)>;
+
+    /// Behaviour of submit() when the queue is full.
+    enum class submit_policy
+    {
+        block,    ///< wait until a worker takes a fit from the queue
+        fail_fast ///< return at once with fit_status::rejected
+    };
+
+    /// Pinning of the worker threads started by start_workers().
+    enum class affinity_policy
+    {
+        none,      ///< threads are scheduled freely
+        cores,     ///< each worker on a single CPU, spread over the NUMA nodes
+        numa_nodes ///< each worker on all CPUs of one NUMA node, nodes used round-robin
+    };
+
+    /// Counters and timings collected by the fitter since its creation.
+    struct statistics
+    {
+        std::uint64_t fits_attempted {0};     ///< all calls to fit()
+        std::uint64_t fits_ok {0};            ///< fits finished with fit_status::ok
+        std::uint64_t fits_failed {0};        ///< fits rejected by the minimizer
+        std::uint64_t fits_empty_range {0};   ///< fits not executed due to empty range
+        std::uint64_t fits_missing_entry {0}; ///< fits without matching entry
+        std::uint64_t fits_skipped {0};       ///< fits skipped as done in the resumed checkpoint
+        std::uint64_t fits_rejected {0};      ///< submissions rejected by the full queue
+
+        std::uint64_t qa_none {0};        ///< QA checker made no decision
+        std::uint64_t qa_chi2_better {0}; ///< QA accepted new parameters
+        std::uint64_t qa_chi2_same {0};   ///< QA found no change
+        std::uint64_t qa_chi2_worse {0};  ///< QA restored old parameters
+
+        double fit_seconds {0.0};                      ///< total time spent in fits
+        std::vector<double> fit_seconds_bounds;        ///< upper bounds of the fit time histogram buckets
+        std::vector<std::uint64_t> fit_seconds_counts; ///< cumulative counts for each bound, last is +Inf
+
+        std::uint64_t imports {0};        ///< number of imported files
+        std::uint64_t import_entries {0}; ///< number of imported entries
+        double import_seconds {0.0};      ///< total import time
+        std::uint64_t exports {0};        ///< number of exported files
+        std::uint64_t export_entries {0}; ///< number of exported entries
+        double export_seconds {0.0};      ///< total export time
+
+        // allocations counted only when the executable links the HelloFitty::alloc_tracker library
+        std::uint64_t alloc_import_count {0}; ///< allocations during imports
+        std::uint64_t alloc_import_bytes {0}; ///< bytes allocated during imports
+        std::uint64_t alloc_fit_count {0};    ///< allocations during fits
+        std::uint64_t alloc_fit_bytes {0};    ///< bytes allocated during fits
+        std::uint64_t alloc_export_count {0}; ///< allocations during exports
+        std::uint64_t alloc_export_bytes {0}; ///< bytes allocated during exports
+
+        std::vector<std::string> worker_bindings; ///< CPUs of each running worker, e.g. "cpu 3" or "unpinned"
+
+        double uptime_seconds {0.0}; ///< time since the fitter was created
+
+        /// Average fitting rate over the fitter lifetime.
+        /// @return number of attempted fits per second
+        auto fits_per_second() const -> double
+        {
+            return uptime_seconds > 0.0 ? static_cast<double>(fits_attempted) / uptime_seconds : 0.0;
+        }
+    };
+
+    /// Output format of the metrics file.
+    enum class metrics_format
+    {
+        json,      ///< single JSON object
+        prometheus ///< Prometheus textfile-collector format
+    };
+
     fitter();
 
     explicit fitter(const fitter&) = delete;
@@ -358,20 +664,62 @@ public:
     /// @return the file was properly imported
     auto init_from_file(std::string input_file, std::string aux_file,
                         priority_mode mode = priority_mode::newer) -> bool;
+    /// @return the auxiliary output file, empty if not set
+    auto get_aux_file() const -> const std::string&;
     /// Force file exporting. If the output file was not set, the function does nothing.
     /// @return true if the file was written
     auto export_to_file(bool update_reference = false) -> bool;
+    /// Export on a background thread, the fitting can continue meanwhile. The entries are copied when the export
+    /// starts. At most one export runs at a time, requests for a file which is already waiting are merged into it.
+    /// @param update_reference write to the reference instead of the auxiliary file
+    /// @return future result, true if the file was written
+    auto export_to_file_async(bool update_reference = false) -> std::shared_future<bool>;
+
+    /// Journal fitted entries, so an interrupted batch job can be resumed. Successfully fitted entries are appended to
+    /// the journal on a background thread after every_fits fits or interval seconds, whichever comes first, failed
+    /// and empty-range fits are not journaled and are fitted again after the resume. In the resume mode
+    /// the entries from the journal replace the imported ones, and fits of their histograms return
+    /// fit_status::skipped. Call after init_from_file() and before fitting. Empty filename disables the journal.
+    /// @param filename journal file
+    /// @param mode start new journal or resume from the existing one
+    /// @param every_fits number of fits between appends, zero disables the count trigger
+    /// @param interval time between appends in seconds, zero disables the time trigger
+    /// @return true if the journal can be written
+    auto set_checkpoint(std::string filename, checkpoint_mode mode = checkpoint_mode::fresh,
+                        std::size_t every_fits = 100, double interval = 30.0) -> bool;
+    /// Append all fitted entries to the journal now. If the journal was not set, the result is false.
+    /// @return future result, true if the journal was written
+    auto flush_checkpoint() -> std::shared_future<bool>;
+
+    /// Append inputs of each histogram fit to a binary capture file: the histogram bins covering the fit range, the
+    /// entry before the fit and the fit options. The file can be replayed with the replay benchmark to profile a
+    /// production workload offline. Rebinned histograms are stored after rebinning. Fits of graphs are not captured.
+    /// Call when no fit is running.
+    /// @param filename capture file, replaced if it exists
+    /// @return true if the file was created
+    auto start_capture(std::string filename) -> bool;
+    /// Close the capture file.
+    auto stop_capture() -> void;
 
     auto find_fit(TH1* hist) const -> entry*;
     auto find_fit(const char* name) const -> entry*;
 
-    /// Find hfp by histogram name, or create from generic if not null.
+    /// Find hfp by histogram name, or create from generic if not null. Without generic, the entry is created from the
+    /// most specific pattern entry matching the name, see insert_pattern().
     /// @param hist object to find hfp for
     /// @param generic object to use as a reference if name not found
-    /// @return hfp found for name, or created from generic if not nullptr, or nullptr
+    /// @return hfp found for name, or created from generic or pattern, or nullptr
     auto find_or_make(TH1* hist, entry* generic = nullptr) -> entry*;
     auto find_or_make(const char* name, entry* generic = nullptr) -> entry*;
 
+    /// Find all entries with names matching the pattern. Prefix and glob queries scan only the ordered range of names
+    /// starting with the literal prefix of the pattern, regex queries scan all entries. Names are matched as stored,
+    /// the name decorator is not applied.
+    /// @param pattern the pattern
+    /// @param mode pattern kind
+    /// @return matching entries
+    auto select(const std::string& pattern, match_mode mode = match_mode::glob) const -> selection;
+
     /// Fit the histogram using entry either located in the collection or using generic entry if provided.
     /// @param hist histogram to be fitted
     /// @param pars histogram fitting pars
@@ -395,10 +743,49 @@ public:
     auto fit(entry* custom, const char* name, TGraph* graph, const char* pars = "BQS",
              const char* gpars = "") -> fit_result;
 
+    /// Start worker threads fitting the submitted histograms. Running workers are stopped first. Call
+    /// ROOT::EnableThreadSafety() before starting more than one worker.
+    /// @param threads number of workers
+    /// @param capacity maximal number of fits waiting in the queue, it bounds the memory when submissions outrun
+    /// the fitting
+    /// @param policy what submit() does when the queue is full
+    /// @param affinity pinning of the workers, Linux only. Memory allocated during the fits, e.g. the function
+    /// instances, is then first touched on the node of the worker. Pinning which fails leaves the worker unpinned.
+    auto start_workers(std::size_t threads, std::size_t capacity = 1024, submit_policy policy = submit_policy::block,
+                       affinity_policy affinity = affinity_policy::none) -> void;
+    /// Finish all submitted fits and stop the workers. Other threads may keep submitting meanwhile, their fits are
+    /// rejected until the workers are started again. Not to be called from a fit callback.
+    auto stop_workers() -> void;
+    /// @return number of submitted fits waiting for a worker
+    auto pending_fits() const -> std::size_t;
+
+    /// Fit the histogram on a worker thread, like fit(TH1*, const char*, const char*). The histogram must stay valid
+    /// until the result is ready. Without workers the fit runs at once on the calling thread.
+    /// @param hist histogram to fit
+    /// @param pars fit options
+    /// @param gpars graphics options
+    /// @return future result, fit_status::rejected if the queue is full with submit_policy::fail_fast, or the workers
+    /// are stopped while the submission waits for a free slot
+    auto submit(TH1* hist, const char* pars = "BQS", const char* gpars = "") -> std::future<fit_result>;
+    /// Fit the histogram on a worker thread and pass the result to the callback. A rejected fit is reported to the
+    /// callback on the calling thread. Exceptions thrown by the fit or the callback are dropped.
+    /// @param hist histogram to fit
+    /// @param callback result receiver
+    /// @param pars fit options
+    /// @param gpars graphics options
+    auto submit(TH1* hist, fit_callback callback, const char* pars = "BQS", const char* gpars = "") -> void;
+
     auto print() const -> void;
 
+    /// Set level of the default logger to info (verbose) or warning.
+    /// @param verbose print fit progress
     static auto set_verbose(bool verbose) -> void;
 
+    /// Use own logger instead of the default one, e.g. to write to file or to silence the fitter.
+    /// @param log the logger, nullptr restores the default logger
+    auto set_logger(std::shared_ptr<logger> log) -> void;
+    auto get_logger() const -> logger&;
+
     /// Insert new pair of name,entry. If the entry for given name exists, update it with the
     /// new value.
     /// @param name histogram name
@@ -410,6 +797,13 @@ public:
     /// @param hfp pair of histogram name and histogram fit entry
     /// @return pointer to the registered entry
     auto insert_parameter(std::pair<std::string, entry> hfp) -> entry*;
+    /// Insert pattern entry, a generic for all names matching the glob pattern which have no own entry. Patterns are
+    /// also read from the parameters file: lines with '*' or '?' in the name, e.g. "h_mass_pt*", and are exported
+    /// after the entries. The longest literal prefix wins if more patterns match, then the first inserted. Entries
+    /// made from a pattern share its compiled functions.
+    /// @param pattern glob pattern, see tools::glob_match()
+    /// @param hfp the generic entry, replaces the entry of an existing pattern
+    auto insert_pattern(std::string pattern, entry hfp) -> void;
 
     auto set_name_decorator(std::string decorator) -> void;
     auto clear_name_decorator() -> void;
@@ -423,6 +817,84 @@ public:
     auto get_function_style() -> draw_opts&;
 
     auto set_qa_checker(fit_qa_checker checker) -> void;
+    /// Use QA checker reading the fit summary. It replaces the checker set with set_qa_checker(). Both get the full
+    /// fit result, in the compact result mode it is released after the QA.
+    /// @param checker QA checker, nullptr restores the fit result checker
+    auto set_qa_summary_checker(fit_qa_summary_checker checker) -> void;
+
+    /// Register observer of the fit stages and of the import and export progress. Without observer each stage costs
+    /// a single branch. Call when no fit or export is running.
+    /// @param observer the observer, nullptr removes it
+    auto set_observer(std::shared_ptr<fit_observer> observer) -> void;
+
+    /// Select what the fit results keep. The compact mode saves memory when the results of many fits are collected.
+    /// Fit with the "S" option to have the EDM and covariance in the summary.
+    /// @param mode result mode
+    auto set_result_mode(result_mode mode) -> void;
+
+    /// Keep the covariance matrix in the fit summaries. Requires the "S" fit option, otherwise the summaries have no
+    /// covariance.
+    /// @param keep store covariance
+    auto set_keep_covariance(bool keep) -> void;
+    /// Write fit summaries to a sidecar file along the exported parameters, and read them back on import. The sidecar
+    /// has the name of the parameters file with the ".fit" suffix.
+    /// @param enable use the sidecar file
+    auto set_summary_sidecar(bool enable) -> void;
+
+    /// Return snapshot of the fitter counters and timings.
+    /// @return statistics snapshot
+    auto stats() const -> statistics;
+
+    /// Periodically write metrics to the file. The file is updated after a fit, import or export if at least
+    /// interval seconds passed since the last write. Empty filename disables the metrics file.
+    /// @param filename metrics file, replaced atomically on each write
+    /// @param format output format
+    /// @param interval minimal time between writes in seconds
+    auto set_metrics_file(std::string filename, metrics_format format = metrics_format::json,
+                          double interval = 10.0) -> void;
+    /// Write metrics file immediately. If the metrics file was not set, the function does nothing.
+    /// @return true if the file was written
+    auto write_metrics() const -> bool;
+
+    /// Copy parameters of all entries into the columns in a single pass. The order of entries is unspecified, but the
+    /// same for all columns.
+    /// @param columns output columns, previous content is replaced
+    auto get_columns(param_columns& columns) const -> void;
+    /// Copy parameters of the selected entries into the columns, in the selection order.
+    /// @param columns output columns, previous content is replaced
+    /// @param entries entries from select()
+    auto get_columns(param_columns& columns, const selection& entries) const -> void;
+    /// Update entries from the columns: values, limits, use of the limits and modes. Limits are switched on or off only
+    /// by has_limits, not by the min and max values. Entries missing in the fitter or with different number of
+    /// parameters are skipped. Errors and status are not written back.
+    /// @param columns input columns
+    /// @return number of updated entries
+    auto set_columns(const param_columns& columns) -> std::size_t;
+
+    /// Evaluate the objective of large fits with ROOT's multithreaded execution policy (the "MULTITHREAD" fit
+    /// option). It is used for histograms with at least bins bins in the fit range, or graphs with at least bins
+    /// points, and only when ROOT::EnableImplicitMT() was called. Fits with "SERIAL" or "MULTITHREAD" in the options
+    /// are left as they are.
+    /// @param bins minimal number of bins, zero disables the automatic switch
+    auto set_parallel_threshold(std::size_t bins) -> void;
+
+    /// Count cycles, instructions, cache misses and branch misses of each minimization with the Linux perf_event_open
+    /// interface, and sum them per entry and per formula. Only user-space events of the fitting thread are counted.
+    /// The counters may be refused by the kernel (perf_event_paranoid) or the container, then the mode is not enabled;
+    /// counters missing on some thread or CPU are left out or stay zero. Call when no fit is running.
+    /// @param enable measure the fits
+    /// @return true if the counters are enabled, false if disabled or unavailable
+    auto set_perf_counters(bool enable) -> bool;
+    /// @return counters per entry name, sorted by name, empty if not measured
+    auto perf_counters_by_entry() const -> std::vector<std::pair<std::string, perf_counts>>;
+    /// @return counters per complete function body, sorted by body, empty if not measured
+    auto perf_counters_by_formula() const -> std::vector<std::pair<std::string, perf_counts>>;
+
+    /// Estimate memory used by the fitter. Formulas shared by many entries are counted once. The cost is a single
+    /// pass over the registry without allocations of note, so it can be called periodically. Each entry is read under
+    /// its lock, so fits may run on other threads meanwhile.
+    /// @return memory breakdown
+    auto memory_usage() const -> memory_breakdown;
 
 private:
     auto import_parameters(const std::string& filename) -> bool;
@@ -439,6 +911,60 @@ struct chi2checker
         if (new_chi2 == old_chi2) { return fitter::fit_qa_status::chi2_same; }
         return fitter::fit_qa_status::chi2_worse;
     }
+
+    auto operator()(const params_vector& old_pars, double old_chi2, const params_vector& new_pars, double new_chi2,
+                    const fit_summary&) -> fitter::fit_qa_status
+    {
+        return (*this)(old_pars, old_chi2, new_pars, new_chi2, TFitResultPtr());
+    }
+};
+
+/// Receives notifications from the fitter stages. All callbacks do nothing by default, so only the needed ones are
+/// overridden. Callbacks are invoked on the fitting threads and on the export thread, they must be thread-safe when
+/// fits run concurrently, and should be short as they run inside the fit.
+class HELLOFITTY_EXPORT fit_observer
+{
+public:
+    virtual ~fit_observer() = default;
+
+    /// Before the entry functions are prepared, the entry is locked.
+    /// @param name histogram name
+    /// @param hfp fitted entry
+    virtual auto before_prepare(const char* /*name*/, const entry& /*hfp*/) -> void {}
+    /// Before the minimization, after the chi2 of the old parameters is computed.
+    /// @param name histogram name
+    /// @param hfp fitted entry
+    virtual auto before_minimize(const char* /*name*/, const entry& /*hfp*/) -> void {}
+    /// After the minimization.
+    /// @param name histogram name
+    /// @param hfp fitted entry, still with the old parameters
+    /// @param status minimizer status, 0 for a successful fit
+    virtual auto after_minimize(const char* /*name*/, const entry& /*hfp*/, int /*status*/) -> void {}
+    /// After the QA checker decided about the new parameters.
+    /// @param name histogram name
+    /// @param hfp fitted entry
+    /// @param qa QA decision
+    /// @param summary summary of the fit
+    virtual auto on_qa(const char* /*name*/, const entry& /*hfp*/, fitter::fit_qa_status /*qa*/,
+                       const fit_summary& /*summary*/) -> void
+    {
+    }
+    /// The old parameters are restored, because the fit failed or the QA rejected it.
+    /// @param name histogram name
+    /// @param hfp fitted entry
+    virtual auto on_restore(const char* /*name*/, const entry& /*hfp*/) -> void {}
+    /// Import progress, called periodically and once when the file is read.
+    /// @param filename parameters file
+    /// @param entries entries imported so far
+    virtual auto on_import_progress(const std::string& /*filename*/, std::size_t /*entries*/) -> void {}
+    /// Export progress, called periodically and once when all entries are written.
+    /// @param filename parameters file
+    /// @param entries entries exported so far
+    /// @param total number of exported entries
+    virtual auto on_export_progress(const std::string& /*filename*/, std::size_t /*entries*/, std::size_t /*total*/)
+        -> void
+    {
+    }
 };
 
 namespace tools
@@ -446,6 +972,17 @@ namespace tools
 
 auto HELLOFITTY_EXPORT format_name(const std::string& name, const std::string& decorator) -> std::string;
 
+/// Match the name against the glob pattern with wildcards '*' for any sequence and '?' for any single character.
+/// @param pattern glob pattern
+/// @param name tested name
+/// @return true if the whole name matches
+auto HELLOFITTY_EXPORT glob_match(const std::string& pattern, const std::string& name) -> bool;
+
+/// Check whether the name is a glob pattern.
+/// @param name entry name
+/// @return true if the name contains '*' or '?'
+auto HELLOFITTY_EXPORT is_pattern(const std::string& name) -> bool;
+
 /// Detect format of the line. A simple check of the pattern characteristic is made. In case of ill-formed line it may
 /// result in false detection.
 /// @param line entry line to be tested
@@ -459,6 +996,24 @@ auto HELLOFITTY_EXPORT detect_format(const std::string& line) -> format_version;
 auto HELLOFITTY_EXPORT parse_line_entry(const std::string& line, format_version version = hf::format_version::detect)
     -> std::pair<std::string, entry>;
 
+/// Format the fit summary as a sidecar file line: name, status, chi2, ndf, edm, errors and optional covariance. The
+/// parameter values are stored in the parameters file.
+/// @param name the entry (histogram) name
+/// @param summary fit summary
+/// @return the summary string
+auto HELLOFITTY_EXPORT format_line_summary(const std::string& name, const fit_summary& summary) -> std::string;
+
+/// Parse the sidecar file line.
+/// @param line summary line
+/// @return pair of the entry name and its fit summary
+auto HELLOFITTY_EXPORT parse_line_summary(const std::string& line) -> std::pair<std::string, fit_summary>;
+
+/// Read all records of the capture file written by fitter::start_capture(). An incomplete last record is ignored.
+/// @param filename capture file
+/// @return captured fits in the fitting order
+/// @throws std::runtime_error if the file can't be opened, format_error if it is not a valid capture
+auto HELLOFITTY_EXPORT read_capture(const std::string& filename) -> std::vector<captured_fit>;
+
 /// Export the entry to the text line using given format. By default the newest v2 is used.
 /// @param name the entry (histogram) name
 /// @param entry fit entry
@@ -467,6 +1022,17 @@ auto HELLOFITTY_EXPORT parse_line_entry(const std::string& line, format_version
 auto HELLOFITTY_EXPORT format_line_entry(const std::string& name, const hf::entry* entry,
                                          format_version version = hf::format_version::v2) -> std::string;
 
+/// Start recording timeline of the fitter stages (import, parsing, compilation, fit phases, export) in the Chrome
+/// trace-event format, which can be opened in Perfetto or chrome://tracing. When tracing is not running, each stage
+/// costs a single branch.
+/// @param filename output trace file, written by stop_tracing()
+/// @return false if tracing is already running
+auto HELLOFITTY_EXPORT start_tracing(std::string filename) -> bool;
+
+/// Stop recording and write all collected spans to the trace file.
+/// @return true if the file was written
+auto HELLOFITTY_EXPORT stop_tracing() -> bool;
+
 } // namespace tools
 
 } // namespace hf
@@ -0,0 +1,144 @@
+/*
+    Hello Fitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HELLOFITTY_SERVER_H
+#define HELLOFITTY_SERVER_H
+
+#include "hellofitty.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace hf
+{
+
+namespace detail
+{
+struct server_impl;
+struct client_impl;
+} // namespace detail
+
+/// Priority class of a fit request. Interactive requests are taken before any waiting batch request.
+enum class request_priority
+{
+    interactive,
+    batch
+};
+
+/// Fitting server listening on a Unix domain socket. The fitter with its imported entries and compiled formulas stays
+/// in memory, so clients do not pay the start-up, import and compilation costs. Clients are served concurrently, fits
+/// run on a pool of worker threads. ROOT::EnableThreadSafety() must be called before the server is started if more
+/// than one worker is used.
+///
+/// The protocol is line based. A request is one line, the reply is one or more lines, the first starting with "ok" or
+/// "error":
+///   fit <interactive|batch> <name> <bins> <xmin> <xmax> <content_1> ... <content_bins>
+///     -> ok <fit_status> <qa_status>, summary <summary line or ->, entry <entry line>
+///   get <name>  -> ok, entry <entry line>
+///   export      -> ok <1 if written, 0 otherwise>
+///   quit        -> connection is closed
+class HELLOFITTY_EXPORT server final
+{
+public:
+    struct options
+    {
+        std::string socket_path;          ///< path of the Unix socket, replaced if it exists
+        std::size_t workers {1};          ///< number of fitting threads
+        std::string fit_options {"BQ0N"}; ///< options passed to each fit
+        double export_interval {60.0};    ///< seconds between exports of the auxiliary file, 0 disables the exports,
+                                          ///< they are also disabled if the fitter has no auxiliary file
+    };
+
+    /// @param fitter fitter with imported entries, must outlive the server
+    /// @param opts server options
+    server(fitter& fitter, options opts);
+
+    server(const server&) = delete;
+    auto operator=(const server&) -> server& = delete;
+
+    /// Stop the server if it is running.
+    ~server();
+
+    /// Bind the socket and start serving on background threads. A stale socket at the path is replaced, any other
+    /// file is left untouched and the start fails.
+    /// @return false if the socket could not be created
+    auto start() -> bool;
+
+    /// Stop accepting, finish the running fits and disconnect the clients. Fitted entries are exported if the
+    /// periodic export is enabled.
+    auto stop() -> void;
+
+    /// Block until stop() is called from another thread.
+    auto wait() -> void;
+
+private:
+    std::unique_ptr<detail::server_impl> m_d;
+};
+
+/// Client of the fitting server.
+class HELLOFITTY_EXPORT client final
+{
+public:
+    struct fit_reply
+    {
+        fitter::fit_status status {fitter::fit_status::missing_entry};
+        fitter::fit_qa_status qa {fitter::fit_qa_status::none};
+        std::optional<fit_summary> summary; ///< summary of the last accepted fit
+        std::string entry_line;             ///< updated entry in the v2 format, see tools::parse_line_entry()
+    };
+
+    /// Connect to the server.
+    /// @param socket_path path of the server socket
+    /// @throws std::runtime_error if the connection fails
+    explicit client(const std::string& socket_path);
+
+    client(const client&) = delete;
+    auto operator=(const client&) -> client& = delete;
+
+    ~client();
+
+    /// Fit the histogram with the server entry of the name.
+    /// @param name entry name
+    /// @param contents bin contents, without underflow and overflow
+    /// @param xmin lower edge of the first bin
+    /// @param xmax upper edge of the last bin
+    /// @param priority request priority class
+    /// @return fit reply
+    /// @throws std::runtime_error if the server reports an error or the connection is lost
+    auto fit(const std::string& name, const std::vector<double>& contents, double xmin, double xmax,
+             request_priority priority = request_priority::interactive) -> fit_reply;
+
+    /// Get the current server entry.
+    /// @param name entry name
+    /// @return entry line in the v2 format, empty if the entry does not exist
+    auto get(const std::string& name) -> std::string;
+
+    /// Ask the server to export the parameters now.
+    /// @return true if the file was written
+    auto request_export() -> bool;
+
+private:
+    std::unique_ptr<detail::client_impl> m_d;
+};
+
+} // namespace hf
+
+#endif /* HELLOFITTY_SERVER_H */
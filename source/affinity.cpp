@@ -0,0 +1,210 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "affinity.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__)
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+
+namespace
+{
+
+#if defined(__linux__)
+/// CPUs the process may run on.
+auto allowed_cpus() -> std::vector<int>
+{
+    std::vector<int> cpus;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) { return cpus; }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(static_cast<std::size_t>(cpu), &set)) { cpus.push_back(cpu); }
+    }
+    return cpus;
+}
+
+/// NUMA nodes with their allowed CPUs, read from sysfs. Nodes without allowed CPUs are left out.
+auto numa_nodes(const std::vector<int>& allowed) -> std::vector<hf::detail::cpu_binding>
+{
+    std::vector<hf::detail::cpu_binding> nodes;
+
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string list;
+    if (!std::getline(online, list)) { return nodes; }
+
+    for (const auto node : hf::detail::parse_cpu_list(list))
+    {
+        std::ifstream cpulist(fmt::format("/sys/devices/system/node/node{:d}/cpulist", node));
+        std::string cpus;
+        if (!std::getline(cpulist, cpus)) { continue; }
+
+        hf::detail::cpu_binding binding;
+        binding.node = node;
+        for (const auto cpu : hf::detail::parse_cpu_list(cpus))
+        {
+            if (std::binary_search(allowed.begin(), allowed.end(), cpu)) { binding.cpus.push_back(cpu); }
+        }
+        if (!binding.cpus.empty()) { nodes.push_back(std::move(binding)); }
+    }
+    return nodes;
+}
+#endif
+
+/// Compact CPU list, e.g. "0-3,8".
+auto format_cpu_list(const std::vector<int>& cpus) -> std::string
+{
+    std::string out;
+    for (size_t i = 0; i < cpus.size();)
+    {
+        auto j = i;
+        while (j + 1 < cpus.size() and cpus[j + 1] == cpus[j] + 1)
+        {
+            ++j;
+        }
+
+        if (!out.empty()) { out += ','; }
+        out += j == i ? fmt::format("{:d}", cpus[i]) : fmt::format("{:d}-{:d}", cpus[i], cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+} // namespace
+
+namespace hf::detail
+{
+
+auto parse_cpu_list(const std::string& list) -> std::vector<int>
+{
+    std::vector<int> cpus;
+
+    std::istringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ','))
+    {
+        if (range.empty()) { continue; }
+
+        char* end = nullptr;
+        const auto first = std::strtol(range.c_str(), &end, 10);
+        if (end == range.c_str() or first < 0) { return {}; }
+
+        auto last = first;
+        if (*end == '-')
+        {
+            const auto* begin = end + 1;
+            last = std::strtol(begin, &end, 10);
+            if (end == begin or last < first) { return {}; }
+        }
+
+        for (auto cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+#if defined(__linux__)
+auto plan_bindings(fitter::affinity_policy policy, std::size_t threads) -> std::vector<cpu_binding>
+{
+    std::vector<cpu_binding> bindings(threads);
+    if (policy == fitter::affinity_policy::none) { return bindings; }
+
+    const auto allowed = allowed_cpus();
+    if (allowed.empty()) { return bindings; }
+
+    auto nodes = numa_nodes(allowed);
+    if (policy == fitter::affinity_policy::numa_nodes)
+    {
+        for (std::size_t i = 0; i < threads and !nodes.empty(); ++i)
+        {
+            bindings[i] = nodes[i % nodes.size()];
+        }
+        return bindings;
+    }
+
+    // single CPUs, taken from the nodes in turn, so the workers are spread over the sockets
+    std::vector<cpu_binding> cpus;
+    if (nodes.empty()) { nodes.push_back({-1, allowed}); }
+    std::size_t largest = 0;
+    for (const auto& node : nodes)
+    {
+        largest = std::max(largest, node.cpus.size());
+    }
+    for (std::size_t index = 0; index < largest; ++index)
+    {
+        for (const auto& node : nodes)
+        {
+            if (index < node.cpus.size()) { cpus.push_back({node.node, {node.cpus[index]}}); }
+        }
+    }
+
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        bindings[i] = cpus[i % cpus.size()];
+    }
+    return bindings;
+}
+
+auto apply_binding(std::thread& thread, const cpu_binding& binding) -> bool
+{
+    if (binding.cpus.empty()) { return false; }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu : binding.cpus)
+    {
+        if (cpu >= 0 and cpu < CPU_SETSIZE) { CPU_SET(static_cast<std::size_t>(cpu), &set); }
+    }
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+}
+#else
+auto plan_bindings(fitter::affinity_policy /*policy*/, std::size_t threads) -> std::vector<cpu_binding>
+{
+    return std::vector<cpu_binding>(threads);
+}
+
+auto apply_binding(std::thread& /*thread*/, const cpu_binding& /*binding*/) -> bool { return false; }
+#endif
+
+auto format_binding(const cpu_binding& binding) -> std::string
+{
+    if (binding.cpus.empty()) { return "unpinned"; }
+    if (binding.cpus.size() == 1) { return fmt::format("cpu {:d}", binding.cpus.front()); }
+
+    const auto cpus = format_cpu_list(binding.cpus);
+    return binding.node >= 0 ? fmt::format("node {:d}: cpus {:s}", binding.node, cpus) : fmt::format("cpus {:s}", cpus);
+}
+
+} // namespace hf::detail
@@ -0,0 +1,56 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "alloc_stats.hpp"
+
+namespace
+{
+// trivially initialized, so reading them from operator new never allocates
+thread_local hf::detail::alloc_counters* current_counters {nullptr};
+thread_local hf::detail::alloc_phase current_phase {hf::detail::alloc_phase::import};
+} // namespace
+
+namespace hf::detail
+{
+
+auto record_allocation(std::size_t size) noexcept -> void
+{
+    auto* counters = current_counters;
+    if (!counters) { return; }
+
+    const auto phase = static_cast<std::size_t>(current_phase);
+    counters->count[phase].fetch_add(1, std::memory_order_relaxed);
+    counters->bytes[phase].fetch_add(size, std::memory_order_relaxed);
+}
+
+alloc_scope::alloc_scope(alloc_counters& counters, alloc_phase phase) noexcept
+    : m_previous_counters(current_counters)
+    , m_previous_phase(current_phase)
+{
+    current_counters = &counters;
+    current_phase = phase;
+}
+
+alloc_scope::~alloc_scope()
+{
+    current_counters = m_previous_counters;
+    current_phase = m_previous_phase;
+}
+
+} // namespace hf::detail
@@ -0,0 +1,63 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Allocation tracker: replaces the global allocation functions of the executable it is linked into, and reports
+// each allocation to the fitter which is running an import, fit or export on the calling thread. Link the
+// HelloFitty::alloc_tracker object library to enable the allocation counters of fitter::stats().
+
+#include "alloc_stats.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+auto tracked_alloc(std::size_t size) -> void*
+{
+    hf::detail::record_allocation(size);
+    if (auto* ptr = std::malloc(size ? size : 1)) { return ptr; }
+    throw std::bad_alloc();
+}
+
+auto tracked_alloc(std::size_t size, const std::nothrow_t&) noexcept -> void*
+{
+    hf::detail::record_allocation(size);
+    return std::malloc(size ? size : 1);
+}
+} // namespace
+
+auto operator new(std::size_t size) -> void* { return tracked_alloc(size); }
+
+auto operator new[](std::size_t size) -> void* { return tracked_alloc(size); }
+
+auto operator new(std::size_t size, const std::nothrow_t& tag) noexcept -> void* { return tracked_alloc(size, tag); }
+
+auto operator new[](std::size_t size, const std::nothrow_t& tag) noexcept -> void* { return tracked_alloc(size, tag); }
+
+auto operator delete(void* ptr) noexcept -> void { std::free(ptr); }
+
+auto operator delete[](void* ptr) noexcept -> void { std::free(ptr); }
+
+auto operator delete(void* ptr, std::size_t /*size*/) noexcept -> void { std::free(ptr); }
+
+auto operator delete[](void* ptr, std::size_t /*size*/) noexcept -> void { std::free(ptr); }
+
+auto operator delete(void* ptr, const std::nothrow_t& /*tag*/) noexcept -> void { std::free(ptr); }
+
+auto operator delete[](void* ptr, const std::nothrow_t& /*tag*/) noexcept -> void { std::free(ptr); }
@@ -0,0 +1,86 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "async_export.hpp"
+
+#include <algorithm>
+#include <exception>
+
+namespace hf::detail
+{
+
+async_exporter::async_exporter(export_function function)
+    : m_function(std::move(function))
+{
+    m_thread = std::thread([this] { run(); });
+}
+
+async_exporter::~async_exporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    if (m_thread.joinable()) { m_thread.join(); }
+}
+
+auto async_exporter::request(std::string filename) -> std::shared_future<bool>
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = std::find_if(m_pending.begin(), m_pending.end(),
+                           [&](const pending_export& pending) { return pending.filename == filename; });
+    if (it != m_pending.end()) { return it->future; }
+
+    pending_export pending;
+    pending.filename = std::move(filename);
+    pending.future = pending.promise.get_future().share();
+    m_pending.push_back(std::move(pending));
+
+    m_cv.notify_one();
+    return m_pending.back().future;
+}
+
+auto async_exporter::run() -> void
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_cv.wait(lock, [this] { return m_stop or !m_pending.empty(); });
+
+        // waiting exports are finished before stopping, so no requested data is lost
+        if (m_pending.empty()) { break; }
+
+        auto current = std::move(m_pending.front());
+        m_pending.erase(m_pending.begin());
+
+        lock.unlock();
+        try
+        {
+            current.promise.set_value(m_function(current.filename));
+        }
+        catch (...)
+        {
+            current.promise.set_exception(std::current_exception());
+        }
+        lock.lock();
+    }
+}
+
+} // namespace hf::detail
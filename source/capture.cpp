@@ -0,0 +1,192 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "capture.hpp"
+
+#include "hellofitty.hpp"
+
+#include <TAxis.h>
+#include <TH1.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+constexpr char capture_magic[] = "HFCAP001";
+constexpr std::size_t capture_magic_size = sizeof(capture_magic) - 1;
+
+template<typename T> auto put(std::string& buffer, T value) -> void
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+auto put_string(std::string& buffer, const std::string& value) -> void
+{
+    put(buffer, static_cast<std::uint32_t>(value.size()));
+    buffer.append(value);
+}
+
+/// Sequential reader of a single record, every read checks the remaining size.
+class record_reader
+{
+public:
+    explicit record_reader(const std::string& record)
+        : m_pos(record.data())
+        , m_end(record.data() + record.size())
+    {
+    }
+
+    template<typename T> auto get(T& value) -> bool
+    {
+        if (static_cast<std::size_t>(m_end - m_pos) < sizeof(T)) { return false; }
+        std::memcpy(&value, m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    auto get_string(std::string& value) -> bool
+    {
+        std::uint32_t size = 0;
+        if (!get(size) or static_cast<std::size_t>(m_end - m_pos) < size) { return false; }
+        value.assign(m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    auto get_doubles(std::vector<double>& values, std::size_t count) -> bool
+    {
+        if (static_cast<std::size_t>(m_end - m_pos) / sizeof(double) < count) { return false; }
+        values.resize(count);
+        std::memcpy(values.data(), m_pos, count * sizeof(double));
+        m_pos += count * sizeof(double);
+        return true;
+    }
+
+    auto at_end() const -> bool { return m_pos == m_end; }
+
+private:
+    const char* m_pos;
+    const char* m_end;
+};
+
+} // namespace
+
+namespace hf
+{
+
+namespace detail
+{
+
+auto capture_writer::open(const std::string& filename) -> std::unique_ptr<capture_writer>
+{
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    stream.write(capture_magic, capture_magic_size);
+    if (!stream) { return nullptr; }
+
+    return std::unique_ptr<capture_writer>(new capture_writer(std::move(stream)));
+}
+
+auto capture_writer::write(const std::string& name, const std::string& options, const std::string& entry_line,
+                           const TH1& hist, double range_min, double range_max) -> void
+{
+    const auto* axis = hist.GetXaxis();
+    const auto first = std::max(axis->FindFixBin(range_min), 1);
+    const auto last = std::min(axis->FindFixBin(range_max), hist.GetNbinsX());
+    const auto bins = last >= first ? static_cast<std::uint32_t>(last - first + 1) : 0U;
+
+    std::string record;
+    record.reserve(4 * sizeof(std::uint32_t) + name.size() + options.size() + entry_line.size() +
+                   (3 * bins + 1) * sizeof(double));
+    put_string(record, name);
+    put_string(record, options);
+    put_string(record, entry_line);
+    put(record, bins);
+    for (auto bin = first; bin <= last; ++bin)
+    {
+        put(record, axis->GetBinLowEdge(bin));
+    }
+    put(record, bins ? axis->GetBinUpEdge(last) : 0.0);
+    for (auto bin = first; bin <= last; ++bin)
+    {
+        put(record, hist.GetBinContent(bin));
+    }
+    for (auto bin = first; bin <= last; ++bin)
+    {
+        put(record, hist.GetBinError(bin));
+    }
+
+    const auto size = static_cast<std::uint32_t>(record.size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    m_stream.write(record.data(), static_cast<std::streamsize>(record.size()));
+    // records reach the file as they are written, a crashed job leaves a readable trace up to its last fit
+    m_stream.flush();
+}
+
+} // namespace detail
+
+namespace tools
+{
+
+auto read_capture(const std::string& filename) -> std::vector<captured_fit>
+{
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream.is_open()) { throw std::runtime_error(fmt::format("Can't open capture file {:s}", filename)); }
+
+    char magic[capture_magic_size] {};
+    if (!stream.read(magic, capture_magic_size) or std::memcmp(magic, capture_magic, capture_magic_size) != 0)
+    {
+        throw format_error(fmt::format("{:s} is not a fit capture file", filename));
+    }
+
+    std::vector<captured_fit> fits;
+    std::string record;
+    std::uint32_t size = 0;
+    // a record cut short by an interrupted writer ends the trace
+    while (stream.read(reinterpret_cast<char*>(&size), sizeof(size)))
+    {
+        record.resize(size);
+        if (!stream.read(&record[0], size)) { break; }
+
+        captured_fit fit;
+        record_reader reader(record);
+        std::uint32_t bins = 0;
+        if (!reader.get_string(fit.name) or !reader.get_string(fit.options) or !reader.get_string(fit.entry_line) or
+            !reader.get(bins) or !reader.get_doubles(fit.edges, bins + 1U) or
+            !reader.get_doubles(fit.contents, bins) or !reader.get_doubles(fit.errors, bins) or !reader.at_end())
+        {
+            throw format_error(fmt::format("Corrupted record {:d} in capture file {:s}", fits.size(), filename));
+        }
+
+        fits.push_back(std::move(fit));
+    }
+
+    return fits;
+}
+
+} // namespace tools
+
+} // namespace hf
@@ -0,0 +1,151 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "checkpoint.hpp"
+
+#include "details.hpp"
+#include "registry.hpp"
+
+#include <fmt/core.h>
+
+#include <exception>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+constexpr auto journal_header = "# hellofitty checkpoint";
+constexpr auto batch_marker = "#batch";
+} // namespace
+
+namespace hf::detail
+{
+
+checkpoint_journal::checkpoint_journal(std::string filename, std::size_t every_fits, double interval)
+    : m_filename(std::move(filename))
+    , m_every_fits(every_fits)
+    , m_interval(std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(interval)))
+    , m_last_append(clock::now())
+    , m_writer([this](const std::string&) { return append(); })
+{
+}
+
+checkpoint_journal::~checkpoint_journal()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_records.empty()) { m_writer.request(m_filename); }
+}
+
+auto checkpoint_journal::create() -> bool
+{
+    std::ofstream journal(m_filename, std::ios::trunc);
+    journal << journal_header << '\n';
+    return static_cast<bool>(journal);
+}
+
+auto checkpoint_journal::resume(entry_registry& registry) -> bool
+{
+    std::ifstream journal(m_filename);
+    if (!journal.is_open()) { return create(); }
+
+    // entries are applied batch by batch, the unfinished tail is dropped
+    std::vector<std::pair<std::string, entry>> batch;
+
+    std::string line;
+    while (std::getline(journal, line))
+    {
+        if (line.empty()) { continue; }
+
+        if (line[0] == '#')
+        {
+            if (line.compare(0, std::char_traits<char>::length(batch_marker), batch_marker) != 0) { continue; }
+
+            for (auto& item : batch)
+            {
+                m_done.insert(item.first);
+                registry.insert_or_assign(std::move(item.first), std::move(item.second));
+            }
+            batch.clear();
+            continue;
+        }
+
+        try
+        {
+            batch.push_back(tools::parse_line_entry(line, format_version::v2));
+        }
+        catch (const std::exception&)
+        {
+            // line cut by a crash, nothing valid can follow it
+            break;
+        }
+    }
+
+    return std::ofstream(m_filename, std::ios::app).is_open();
+}
+
+auto checkpoint_journal::record(const std::string& name, const entry& hfp) -> void
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_records.emplace_back(name, hfp);
+    ++m_fits_since_append;
+
+    const auto now = clock::now();
+    const auto due = (m_every_fits != 0 and m_fits_since_append >= m_every_fits) or
+                     (m_interval != clock::duration::zero() and now - m_last_append >= m_interval);
+    if (!due) { return; }
+
+    m_fits_since_append = 0;
+    m_last_append = now;
+    lock.unlock();
+
+    m_writer.request(m_filename);
+}
+
+auto checkpoint_journal::flush() -> std::shared_future<bool> { return m_writer.request(m_filename); }
+
+auto checkpoint_journal::append() -> bool
+{
+    std::vector<std::pair<std::string, entry>> records;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        records.swap(m_records);
+    }
+    if (records.empty()) { return true; }
+
+    // formatting happens here, off the fitting threads
+    std::string batch;
+    for (const auto& item : records)
+    {
+        batch += tools::format_line_entry(item.first, &item.second, format_version::v2);
+        batch += '\n';
+    }
+    batch += fmt::format("{:s} {:d}\n", batch_marker, records.size());
+
+    std::ofstream journal(m_filename, std::ios::app);
+    journal << batch;
+    journal.flush();
+    if (journal) { return true; }
+
+    // keep the entries for the next attempt, newer records of the same name are applied later on resume
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_records.insert(m_records.begin(), std::make_move_iterator(records.begin()),
+                     std::make_move_iterator(records.end()));
+    return false;
+}
+
+} // namespace hf::detail
@@ -0,0 +1,134 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hellofitty.hpp"
+
+#include "details.hpp"
+
+#include <stdexcept>
+
+namespace
+{
+auto clear_columns(hf::param_columns& columns, std::size_t entries) -> void
+{
+    columns.names.clear();
+    columns.offsets.clear();
+    columns.status.clear();
+    columns.values.clear();
+    columns.errors.clear();
+    columns.min.clear();
+    columns.max.clear();
+    columns.has_limits.clear();
+    columns.modes.clear();
+
+    columns.names.reserve(entries);
+    columns.offsets.reserve(entries + 1);
+    columns.status.reserve(entries);
+}
+
+/// Append the entry, the caller holds the entry lock.
+auto append_columns(hf::param_columns& columns, const std::string& name, const hf::detail::entry_impl& hfp) -> void
+{
+    const auto* summary = hfp.summary.get();
+    const auto& pars = hfp.pars;
+
+    columns.names.push_back(name);
+    columns.offsets.push_back(columns.values.size());
+    columns.status.push_back(summary ? summary->status : -1);
+
+    for (size_t i = 0; i < pars.size(); ++i)
+    {
+        columns.values.push_back(pars[i].value);
+        columns.errors.push_back(summary and i < summary->errors.size() ? summary->errors[i] : 0.0);
+        columns.min.push_back(pars[i].min);
+        columns.max.push_back(pars[i].max);
+        columns.has_limits.push_back(pars[i].has_limits ? 1 : 0);
+        columns.modes.push_back(pars[i].mode);
+    }
+}
+
+} // namespace
+
+namespace hf
+{
+
+auto fitter::get_columns(param_columns& columns) const -> void
+{
+    clear_columns(columns, m_d->hfpmap.size());
+
+    m_d->hfpmap.for_each(
+        [&](const std::string& name, const entry& hfp)
+        {
+            std::lock_guard<std::mutex> lock(detail::entry_mutex(&hfp));
+            append_columns(columns, name, *hfp.m_d);
+        });
+
+    columns.offsets.push_back(columns.values.size());
+}
+
+auto fitter::get_columns(param_columns& columns, const selection& entries) const -> void
+{
+    clear_columns(columns, entries.size());
+
+    for (const auto& item : entries)
+    {
+        std::lock_guard<std::mutex> lock(detail::entry_mutex(item.second));
+        append_columns(columns, item.first, *item.second->m_d);
+    }
+
+    columns.offsets.push_back(columns.values.size());
+}
+
+auto fitter::set_columns(const param_columns& columns) -> std::size_t
+{
+    const auto params = columns.values.size();
+    if (columns.offsets.size() != columns.names.size() + 1 or columns.offsets.back() != params or
+        columns.min.size() != params or columns.max.size() != params or columns.has_limits.size() != params or
+        columns.modes.size() != params)
+    {
+        throw std::invalid_argument("Inconsistent sizes of parameter columns.");
+    }
+
+    std::size_t updated = 0;
+    for (size_t i = 0; i < columns.names.size(); ++i)
+    {
+        auto* hfp = m_d->hfpmap.find(columns.names[i]);
+        if (!hfp) { continue; }
+
+        std::lock_guard<std::mutex> lock(detail::entry_mutex(hfp));
+
+        auto& pars = hfp->m_d->pars;
+        const auto first = columns.offsets[i];
+        if (columns.offsets[i + 1] < first or columns.offsets[i + 1] - first != pars.size()) { continue; }
+
+        for (size_t j = 0; j < pars.size(); ++j)
+        {
+            auto& par = pars[j];
+            par.value = columns.values[first + j];
+            par.mode = columns.modes[first + j];
+            par.min = columns.min[first + j];
+            par.max = columns.max[first + j];
+            par.has_limits = columns.has_limits[first + j] != 0;
+        }
+        ++updated;
+    }
+
+    return updated;
+}
+
+} // namespace hf
@@ -22,6 +22,8 @@
 
 #include "details.hpp"
 
+#include <mutex>
+
 template<>
 struct fmt::formatter<hf::entry>
 {
@@ -48,6 +50,47 @@ struct fmt::formatter<hf::entry>
 namespace hf
 {
 
+namespace detail
+{
+
+auto intern_formula(std::vector<std::string> bodies, Double_t range_min, Double_t range_max)
+    -> std::shared_ptr<const formula_impl>
+{
+    static std::mutex cache_mutex;
+    static std::unordered_map<std::string, std::weak_ptr<const formula_impl>> cache;
+    static size_t purge_threshold = 64;
+
+    std::string key;
+    for (const auto& body : bodies)
+    {
+        key += body;
+        key += '\n'; // bodies never contain new line, so different splits of the same sum differ
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    auto& cached = cache[key];
+    if (auto formula = cached.lock()) { return formula; }
+
+    auto formula = std::make_shared<const formula_impl>(std::move(bodies), range_min, range_max);
+    cached = formula;
+
+    // forget formulas of destroyed entries, amortized by growing the threshold with the cache
+    if (cache.size() >= purge_threshold)
+    {
+        for (auto it = cache.begin(); it != cache.end();)
+        {
+            if (it->second.expired()) { it = cache.erase(it); }
+            else { ++it; }
+        }
+        purge_threshold = std::max<size_t>(64, cache.size() * 2);
+    }
+
+    return formula;
+}
+
+} // namespace detail
+
 entry::entry()
     : m_d {make_unique<detail::entry_impl>()}
 {
@@ -85,7 +128,7 @@ auto entry::add_function(std::string formula) -> int
 
 auto entry::get_function(int function_index) const -> const char*
 {
-    return m_d->funcs.at(int2size_t(function_index)).body_string.c_str();
+    return m_d->get_functions().at(int2size_t(function_index)).body_string.c_str();
 }
 
 auto entry::set_param(int par_id, hf::param par) -> void
@@ -148,16 +191,18 @@ auto entry::restore_param_limits(int par_id) -> void
 
 auto entry::get_param(int par_id) const -> hf::param { return param(par_id); }
 
-auto get_param_name_index(TF1* fun, const char* name) -> Int_t
+auto get_param_name_index(const detail::entry_impl* hfp_m_d, const char* name) -> Int_t
 {
-    auto par_index = fun->GetParNumber(name);
+    if (!hfp_m_d->formula) { throw hf::index_error("No such parameter"); }
+
+    auto par_index = hfp_m_d->formula->complete_function_object.GetParNumber(name);
     if (par_index == -1) { throw hf::index_error("No such parameter"); }
     return par_index;
 }
 
 auto entry::get_param(const char* name) const -> hf::param
 {
-    return get_param(get_param_name_index(&m_d->complete_function_object, name));
+    return get_param(get_param_name_index(m_d.get(), name));
 }
 
 auto entry::param(int par_id) const -> const hf::param&
@@ -180,7 +225,7 @@ auto entry::param(int par_id) -> hf::param&
 
 auto entry::param(const char* name) const -> const hf::param&
 {
-    return param(get_param_name_index(&m_d->complete_function_object, name));
+    return param(get_param_name_index(m_d.get(), name));
 }
 
 auto entry::param(const char* name) -> hf::param&
@@ -195,10 +240,11 @@ auto entry::set_fit_range(Double_t range_lower, Double_t range_upper) -> void
     m_d->range_min = range_lower;
     m_d->range_max = range_upper;
 
-    m_d->complete_function_object.SetRange(range_lower, range_upper);
-    for (auto& f : m_d->funcs)
+    // instances not created yet take the range at creation
+    if (m_d->instances.complete) { m_d->instances.complete->SetRange(range_lower, range_upper); }
+    for (auto& f : m_d->instances.partial)
     {
-        f.function_obj.SetRange(range_lower, range_upper);
+        if (f) { f->SetRange(range_lower, range_upper); }
     }
 }
 
@@ -206,11 +252,11 @@ auto entry::get_fit_range_min() const -> Double_t { return m_d->range_min; }
 
 auto entry::get_fit_range_max() const -> Double_t { return m_d->range_max; }
 
-auto entry::get_functions_count() const -> int { return size_t2int(m_d->funcs.size()); }
+auto entry::get_functions_count() const -> int { return size_t2int(m_d->get_functions().size()); }
 
 auto entry::get_function_object(int function_index) const -> const TF1&
 {
-    return m_d->funcs.at(int2size_t(function_index)).function_obj;
+    return m_d->get_partial_function(int2size_t(function_index));
 }
 
 auto entry::get_function_object(int function_index) -> TF1&
@@ -220,8 +266,7 @@ auto entry::get_function_object(int function_index) -> TF1&
 
 auto entry::get_function_object() const -> const TF1&
 {
-    if (!m_d->complete_function_object.IsValid()) { m_d->compile(); }
-    return m_d->complete_function_object;
+    return m_d->get_complete_function();
 }
 
 auto entry::get_function_object() -> TF1&
@@ -239,7 +284,7 @@ auto entry::clone_function(const char* new_name) -> std::unique_ptr<TF1>
     return std::unique_ptr<TF1>(dynamic_cast<TF1*>(get_function_object().Clone(new_name)));
 }
 
-auto entry::get_function_params_count() const -> int { return get_function_object().GetNpar(); }
+auto entry::get_function_params_count() const -> int { return m_d->get_npar(); }
 
 auto entry::get_flag_rebin() const -> int { return m_d->rebin; }
 
@@ -252,7 +297,7 @@ auto entry::print(const std::string& name, bool detailed) const -> void
     fmt::print("## name: {:s}    rebin: {:d}   range: {:g} -- {:g}  param num: {:d}  {:s}\n", name, m_d->rebin,
                m_d->range_min, m_d->range_max, get_function_params_count(), get_flag_disabled() ? "DISABLED" : "");
 
-    for (const auto& func : m_d->funcs)
+    for (const auto& func : m_d->get_functions())
     {
         func.print(detailed);
     }
@@ -287,7 +332,9 @@ auto entry::backup() -> void { m_d->backup(); }
 
 auto entry::restore() -> void { m_d->restore(); }
 
-auto entry::drop() -> void { m_d->parameters_backup.clear(); }
+auto entry::drop() -> void { m_d->drop(); }
+
+auto entry::get_fit_summary() const -> const fit_summary* { return m_d->summary.get(); }
 
 auto entry::set_function_style(int function_index) -> draw_opts&
 {
@@ -0,0 +1,119 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "fit_queue.hpp"
+
+#include <algorithm>
+#include <exception>
+
+namespace hf::detail
+{
+
+fit_queue::fit_queue(fit_function function, std::vector<cpu_binding> bindings, std::size_t capacity,
+                     fitter::submit_policy policy)
+    : m_function(std::move(function))
+    , m_capacity(std::max<std::size_t>(capacity, 1))
+    , m_policy(policy)
+{
+    if (bindings.empty()) { bindings.resize(1); }
+
+    m_threads.reserve(bindings.size());
+    for (const auto& binding : bindings)
+    {
+        // pinned right after the start, before the worker takes its first fit
+        m_threads.emplace_back([this] { run(); });
+        m_bindings.push_back(format_binding(apply_binding(m_threads.back(), binding) ? binding : cpu_binding {}));
+    }
+}
+
+fit_queue::~fit_queue() { stop(); }
+
+auto fit_queue::stop() -> void
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_not_empty.notify_all();
+    m_not_full.notify_all();
+    for (auto& thread : m_threads)
+    {
+        if (thread.joinable()) { thread.join(); }
+    }
+}
+
+auto fit_queue::push(queued_fit& job) -> bool
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_jobs.size() >= m_capacity)
+    {
+        if (m_policy == fitter::submit_policy::fail_fast) { return false; }
+        m_not_full.wait(lock, [this] { return m_stop or m_jobs.size() < m_capacity; });
+    }
+
+    // the workers may have exited already, nobody would take the job
+    if (m_stop) { return false; }
+
+    m_jobs.push_back(std::move(job));
+    lock.unlock();
+
+    m_not_empty.notify_one();
+    return true;
+}
+
+auto fit_queue::pending() const -> std::size_t
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size();
+}
+
+auto fit_queue::bindings() const -> std::vector<std::string> { return m_bindings; }
+
+auto fit_queue::run() -> void
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_not_empty.wait(lock, [this] { return m_stop or !m_jobs.empty(); });
+
+        // waiting fits are finished before stopping, so no submitted future is left without a result
+        if (m_jobs.empty()) { break; }
+
+        auto job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+
+        lock.unlock();
+        m_not_full.notify_one();
+
+        try
+        {
+            auto result = m_function(job.hist, job.pars.c_str(), job.gpars.c_str());
+            if (job.callback) { job.callback(std::move(result)); }
+            else { job.promise.set_value(std::move(result)); }
+        }
+        catch (...)
+        {
+            // an exception thrown by the callback is dropped, there is no one to receive it
+            if (!job.callback) { job.promise.set_exception(std::current_exception()); }
+        }
+        lock.lock();
+    }
+}
+
+} // namespace hf::detail
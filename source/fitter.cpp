@@ -27,7 +27,10 @@
 #include <TGraph.h>
 #include <TH1.h>
 #include <TList.h>
+#include <TROOT.h>
 
+#include <cctype>
+#include <cstdio>
 #include <fstream>
 
 #if __cplusplus >= 201703L
@@ -36,10 +39,11 @@
 #    include <sys/stat.h>
 #endif
 
-bool hf::detail::fitter_impl::verbose_flag = true;
-
 namespace
 {
+// entries between progress notifications of the observer
+constexpr std::size_t progress_step = 1024;
+
 enum class source
 {
     none,
@@ -107,7 +111,14 @@ struct fmt::formatter<hf::entry>
 namespace hf
 {
 
-auto fitter::set_verbose(bool verbose) -> void { detail::fitter_impl::verbose_flag = verbose; }
+auto fitter::set_verbose(bool verbose) -> void
+{
+    logger::default_logger()->set_level(verbose ? log_level::info : log_level::warning);
+}
+
+auto fitter::set_logger(std::shared_ptr<logger> log) -> void { m_d->log = std::move(log); }
+
+auto fitter::get_logger() const -> logger& { return m_d->get_logger(); }
 
 fitter::fitter()
     : m_d {make_unique<detail::fitter_impl>()}
@@ -115,27 +126,53 @@ fitter::fitter()
     m_d->mode = priority_mode::newer;
 }
 
-fitter::fitter(fitter&&) = default;
+// the workers call the fitter they were started by, so they can't outlive its move
+fitter::fitter(fitter&& other)
+{
+    other.stop_workers();
+    m_d = std::move(other.m_d);
+}
+
+auto fitter::operator=(fitter&& other) -> fitter&
+{
+    if (this == &other) { return *this; }
+
+    stop_workers();
+    other.stop_workers();
+    m_d = std::move(other.m_d);
+    return *this;
+}
 
-auto fitter::operator=(fitter&&) -> fitter& = default;
+fitter::~fitter()
+{
+    stop_workers();
 
-fitter::~fitter() = default;
+    // final metrics update, so the last state of the job is always visible
+    if (m_d) { write_metrics(); }
+}
 
 auto fitter::init_from_file(std::string filename) -> bool
 {
     m_d->par_ref = std::move(filename);
 
-    if (!m_d->par_ref.c_str()) { fmt::print(stderr, "No reference input file given\n"); }
-    if (!m_d->par_aux.c_str()) { fmt::print(stderr, "No output file given\n"); }
+    auto& log = m_d->get_logger();
+
+    if (!m_d->par_ref.c_str()) { log.log(log_level::error, "No reference input file given"); }
+    if (!m_d->par_aux.c_str()) { log.log(log_level::error, "No output file given"); }
 
     auto selected = select_source(m_d->par_ref.c_str(), m_d->par_aux.c_str());
 
-    fmt::print("Available source: [{:c}] REF  [{:c}] AUX\n",
-               selected != source::only_auxiliary and selected != source::none ? 'x' : ' ',
-               selected != source::only_reference and selected != source::none ? 'x' : ' ');
-    fmt::print("Selected source : [{:c}] REF  [{:c}] AUX\n",
-               (selected == source::reference or selected == source::only_reference) ? 'x' : ' ',
-               (selected == source::auxiliary or selected == source::only_auxiliary) ? 'x' : ' ');
+    if (log.enabled(log_level::info))
+    {
+        log.log(log_level::info,
+                fmt::format("Available source: [{:c}] REF  [{:c}] AUX",
+                            selected != source::only_auxiliary and selected != source::none ? 'x' : ' ',
+                            selected != source::only_reference and selected != source::none ? 'x' : ' '));
+        log.log(log_level::info,
+                fmt::format("Selected source : [{:c}] REF  [{:c}] AUX",
+                            (selected == source::reference or selected == source::only_reference) ? 'x' : ' ',
+                            (selected == source::auxiliary or selected == source::only_auxiliary) ? 'x' : ' '));
+    }
 
     if (selected == source::none) { return false; }
 
@@ -173,6 +210,8 @@ auto fitter::init_from_file(std::string filename, std::string auxname, priority_
     return init_from_file(std::move(filename));
 }
 
+auto fitter::get_aux_file() const -> const std::string& { return m_d->par_aux; }
+
 auto fitter::export_to_file(bool update_reference) -> bool
 {
     if (!update_reference) { return export_parameters(m_d->par_aux); }
@@ -181,10 +220,7 @@ auto fitter::export_to_file(bool update_reference) -> bool
 
 auto fitter::insert_parameter(std::pair<std::string, entry> hfp) -> entry*
 {
-    auto res = m_d->hfpmap.emplace(std::move(hfp));
-    if (!res.second) { res.first->second = hfp.second; }
-
-    return &res.first->second;
+    return m_d->hfpmap.insert_or_assign(std::move(hfp.first), std::move(hfp.second));
 }
 
 auto fitter::insert_parameter(std::string name, entry hfp) -> entry*
@@ -192,42 +228,252 @@ auto fitter::insert_parameter(std::string name, entry hfp) -> entry*
     return insert_parameter(std::make_pair(std::move(name), std::move(hfp)));
 }
 
+auto fitter::insert_pattern(std::string pattern, entry hfp) -> void
+{
+    m_d->patterns.insert(std::move(pattern), std::move(hfp));
+}
+
 auto fitter::import_parameters(const std::string& filename) -> bool
 {
+    detail::trace_span span("import_parameters", filename.c_str());
+    detail::alloc_scope alloc(m_d->allocations, detail::alloc_phase::import);
+
     std::ifstream fparfile(filename.c_str());
     if (!fparfile.is_open())
     {
-        fmt::print(stderr, "No file {:s} to open.\n", filename);
+        m_d->get_logger().log(log_level::error, fmt::format("No file {:s} to open.", filename));
         return false;
     }
 
     m_d->hfpmap.clear();
+    m_d->patterns.clear();
+
+    const auto start = detail::metrics_impl::clock::now();
+
+    auto* observer = m_d->observer.get();
+    std::size_t imported = 0;
 
     std::string line;
     while (std::getline(fparfile, line))
     {
-        insert_parameter(tools::parse_line_entry(line, m_d->input_format_version));
+        auto parsed = tools::parse_line_entry(line, m_d->input_format_version);
+        if (tools::is_pattern(parsed.first))
+        {
+            m_d->patterns.insert(std::move(parsed.first), std::move(parsed.second));
+        }
+        else { insert_parameter(std::move(parsed)); }
+        if (observer and ++imported % progress_step == 0) { observer->on_import_progress(filename, imported); }
+    }
+    if (observer) { observer->on_import_progress(filename, imported); }
+
+    if (m_d->summary_sidecar)
+    {
+        for (auto& item : m_d->read_summaries(filename + ".fit"))
+        {
+            if (auto* hfp = m_d->hfpmap.find(item.first))
+            {
+                // values are kept only in the parameters file
+                for (const auto& par : hfp->m_d->pars)
+                {
+                    item.second.params.push_back(par.value);
+                }
+                hfp->m_d->summary = std::make_shared<const fit_summary>(std::move(item.second));
+            }
+        }
+    }
+
+    m_d->metrics.record_import(m_d->hfpmap.size(), detail::metrics_impl::clock::now() - start);
+    m_d->metrics.write_if_due();
+
+    return true;
+}
+
+auto fitter::export_parameters(const std::string& filename) -> bool { return m_d->export_parameters(filename); }
+
+auto fitter::export_to_file_async(bool update_reference) -> std::shared_future<bool>
+{
+    return m_d->get_exporter().request(update_reference ? m_d->par_ref : m_d->par_aux);
+}
+
+auto fitter::set_checkpoint(std::string filename, checkpoint_mode mode, std::size_t every_fits, double interval)
+    -> bool
+{
+    // the previous journal appends its remaining entries when destroyed
+    m_d->checkpoint.reset();
+    if (filename.empty()) { return true; }
+
+    auto& log = m_d->get_logger();
+
+    auto journal = make_unique<detail::checkpoint_journal>(filename, every_fits, interval);
+    const auto ok = mode == checkpoint_mode::resume ? journal->resume(m_d->hfpmap) : journal->create();
+    if (!ok)
+    {
+        log.log(log_level::error, fmt::format("Can't write checkpoint file {:s}.", filename));
+        return false;
+    }
+
+    if (mode == checkpoint_mode::resume and log.enabled(log_level::info))
+    {
+        log.log(log_level::info,
+                fmt::format("Resumed {:d} entries from checkpoint {:s}.", journal->done_count(), filename));
+    }
+
+    m_d->checkpoint = std::move(journal);
+    return true;
+}
+
+auto fitter::flush_checkpoint() -> std::shared_future<bool>
+{
+    if (m_d->checkpoint) { return m_d->checkpoint->flush(); }
+
+    std::promise<bool> none;
+    none.set_value(false);
+    return none.get_future().share();
+}
+
+auto fitter::start_capture(std::string filename) -> bool
+{
+    m_d->capture = detail::capture_writer::open(filename);
+    if (!m_d->capture)
+    {
+        m_d->get_logger().log(log_level::error, fmt::format("Can't create capture file {:s}.", filename));
+        return false;
     }
 
     return true;
 }
 
-auto fitter::export_parameters(const std::string& filename) -> bool
+auto fitter::stop_capture() -> void { m_d->capture.reset(); }
+
+auto detail::fitter_impl::parallel_options(const char* pars, std::size_t points, std::string& storage) const
+    -> const char*
+{
+    if (parallel_bins == 0 or points < parallel_bins or !ROOT::IsImplicitMTEnabled()) { return pars; }
+
+    storage = pars;
+    std::transform(storage.begin(), storage.end(), storage.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    if (storage.find("SERIAL") != std::string::npos or storage.find("MULTITHREAD") != std::string::npos)
+    {
+        return pars;
+    }
+
+    storage = pars;
+    storage += " MULTITHREAD";
+    return storage.c_str();
+}
+
+auto detail::fitter_impl::export_parameters(const std::string& filename) -> bool
 {
-    std::ofstream fparfile(filename);
+    detail::trace_span span("export_parameters", filename.c_str());
+    detail::alloc_scope alloc(allocations, detail::alloc_phase::export_file);
+
+    if (filename.empty()) { return false; }
+
+    // synchronous, asynchronous and server exports may run at once and would clobber each other's temporary file
+    std::lock_guard<std::mutex> lock(export_mutex);
+
+    // written aside and renamed, so readers never see a partial file
+    const auto tmp_filename = filename + ".tmp";
+    std::ofstream fparfile(tmp_filename);
     if (!fparfile.is_open())
     {
-        fmt::print(stderr, "Can't create output file {:s}. Skipping...\n", filename);
+        get_logger().log(log_level::error, fmt::format("Can't create output file {:s}. Skipping...", filename));
         return false;
     }
-    else
+
+    const auto start = detail::metrics_impl::clock::now();
+
+    // consistent copy, fits may still run on other threads
+    const auto entries = hfpmap.snapshot();
+
+    auto& export_logger = get_logger();
+    if (export_logger.enabled(log_level::info))
+    {
+        export_logger.log(log_level::info,
+                          fmt::format("Output file {:s} opened...  Exporting {:d} entries.", filename, entries.size()));
+    }
+
+    std::size_t exported = 0;
+    for (const auto& item : entries)
+    {
+        fparfile << tools::format_line_entry(item.first, &item.second, output_format_version) << '\n';
+        if (observer and ++exported % progress_step == 0)
+        {
+            observer->on_export_progress(filename, exported, entries.size());
+        }
+    }
+    for (const auto& item : patterns.snapshot())
+    {
+        fparfile << tools::format_line_entry(item.first, &item.second, output_format_version) << '\n';
+    }
+    fparfile.close();
+    if (observer) { observer->on_export_progress(filename, entries.size(), entries.size()); }
+
+    if (!fparfile or std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        export_logger.log(log_level::error, fmt::format("Can't write output file {:s}. Skipping...", filename));
+        std::remove(tmp_filename.c_str());
+        return false;
+    }
+
+    if (summary_sidecar and !export_summaries(filename + ".fit", entries)) { return false; }
+
+    metrics.record_export(entries.size(), detail::metrics_impl::clock::now() - start);
+    metrics.write_if_due();
+
+    return true;
+}
+
+auto detail::fitter_impl::read_summaries(const std::string& filename)
+    -> std::vector<std::pair<std::string, fit_summary>>
+{
+    std::vector<std::pair<std::string, fit_summary>> summaries;
+
+    std::ifstream sidecar(filename);
+    if (!sidecar.is_open()) { return summaries; }
+
+    std::string line;
+    while (std::getline(sidecar, line))
+    {
+        if (line.empty()) { continue; }
+
+        try
+        {
+            summaries.push_back(tools::parse_line_summary(line));
+        }
+        catch (const format_error& e)
+        {
+            // summaries are auxiliary, the parameters stay usable without them
+            get_logger().log(log_level::warning, e.what());
+        }
+    }
+
+    return summaries;
+}
+
+auto detail::fitter_impl::export_summaries(const std::string& filename,
+                                           const std::vector<std::pair<std::string, entry>>& entries) -> bool
+{
+    const auto tmp_filename = filename + ".tmp";
+    std::ofstream sidecar(tmp_filename);
+
+    for (const auto& item : entries)
     {
-        fmt::print("Output file {:s} opened...  Exporting {:d} entries.\n", filename, m_d->hfpmap.size());
-        for (auto it = m_d->hfpmap.begin(); it != m_d->hfpmap.end(); ++it)
+        if (const auto* summary = item.second.get_fit_summary())
         {
-            fparfile << tools::format_line_entry(it->first, &it->second, m_d->output_format_version) << std::endl;
+            sidecar << tools::format_line_summary(item.first, *summary) << '\n';
         }
     }
+    sidecar.close();
+
+    if (!sidecar or std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        get_logger().log(log_level::error, fmt::format("Can't write fit summary file {:s}. Skipping...", filename));
+        std::remove(tmp_filename.c_str());
+        return false;
+    }
+
     return true;
 }
 
@@ -235,10 +481,7 @@ auto fitter::find_fit(TH1* hist) const -> entry* { return find_fit(hist->GetName
 
 auto fitter::find_fit(const char* name) const -> entry*
 {
-    auto it = m_d->hfpmap.find(tools::format_name(name, m_d->name_decorator));
-    if (it != m_d->hfpmap.end()) { return &it->second; }
-
-    return nullptr;
+    return m_d->hfpmap.find(tools::format_name(name, m_d->name_decorator));
 }
 
 auto fitter::find_or_make(TH1* hist, entry* generic) -> entry* { return find_or_make(hist->GetName(), generic); }
@@ -248,17 +491,42 @@ auto fitter::find_or_make(const char* name, entry* generic) -> entry*
     entry* hfp = find_fit(name);
     if (!hfp and generic)
     {
-        if (detail::fitter_impl::verbose_flag)
+        auto& log = m_d->get_logger();
+        if (log.enabled(log_level::info))
         {
-            fmt::print("HFP for histogram {:s} not found, trying from generic.\n", name);
+            log.log(log_level::info, fmt::format("HFP for histogram {:s} not found, trying from generic.", name));
         }
 
         if (!generic->get_functions_count()) { throw std::logic_error("Generic Fit Entry has no functions."); }
 
-        hfp = insert_parameter(std::string(name), *generic);
+        // another thread may have created it in the meantime
+        const auto inserted = m_d->hfpmap.find_or_insert(name, *generic);
+        hfp = inserted.first;
         if (!hfp) { throw std::logic_error("Could not insert new parameter."); }
 
-        if (detail::fitter_impl::verbose_flag) { fmt::print("HFP for histogram {:s} created from generic.\n", name); }
+        if (inserted.second and log.enabled(log_level::info))
+        {
+            log.log(log_level::info, fmt::format("HFP for histogram {:s} created from generic.", name));
+        }
+    }
+    else if (!hfp and m_d->patterns.size())
+    {
+        // registered under the decorated name, as find_fit() looks it up
+        const auto decorated = tools::format_name(name, m_d->name_decorator);
+        m_d->patterns.match(decorated,
+                            [&](const std::string& pattern, const entry& source)
+                            {
+                                const auto inserted = m_d->hfpmap.find_or_insert(decorated, source);
+                                hfp = inserted.first;
+
+                                auto& log = m_d->get_logger();
+                                if (inserted.second and log.enabled(log_level::info))
+                                {
+                                    log.log(log_level::info, fmt::format("HFP for histogram {:s} created from "
+                                                                         "pattern {:s}.",
+                                                                         name, pattern));
+                                }
+                            });
     }
 
     return hfp;
@@ -267,7 +535,7 @@ auto fitter::find_or_make(const char* name, entry* generic) -> entry*
 auto fitter::fit(TH1* hist, const char* pars, const char* gpars) -> fit_result
 {
     entry* hfp = find_or_make(hist->GetName());
-    if (!hfp) { return {fit_status::missing_entry, hfp}; }
+    if (!hfp) { return m_d->record_missing_entry(); }
 
     return fit(hfp, hist, pars, gpars);
 }
@@ -275,13 +543,25 @@ auto fitter::fit(TH1* hist, const char* pars, const char* gpars) -> fit_result
 auto fitter::fit(TH1* hist, entry* generic, const char* pars, const char* gpars) -> fit_result
 {
     entry* hfp = find_or_make(hist->GetName(), generic);
-    if (!hfp) { return {fit_status::missing_entry, hfp}; }
+    if (!hfp) { return m_d->record_missing_entry(); }
 
     return fit(hfp, hist, pars, gpars);
 }
 
 auto fitter::fit(entry* custom, TH1* hist, const char* pars, const char* gpars) -> fit_result
 {
+    const auto start = detail::metrics_impl::clock::now();
+    detail::alloc_scope alloc(m_d->allocations, detail::alloc_phase::fit);
+
+    std::string checkpoint_name;
+    if (m_d->checkpoint)
+    {
+        checkpoint_name = tools::format_name(hist->GetName(), m_d->name_decorator);
+        if (m_d->checkpoint->is_done(checkpoint_name)) { return m_d->record_fit({fit_status::skipped, custom}, start); }
+    }
+
+    std::lock_guard<std::mutex> lock(detail::entry_mutex(custom));
+
     custom->backup();
 
     Int_t bin_l = hist->FindBin(custom->get_fit_range_min());
@@ -289,19 +569,97 @@ auto fitter::fit(entry* custom, TH1* hist, const char* pars, const char* gpars)
 
     if (custom->get_flag_rebin() != 0) { hist->Rebin(custom->get_flag_rebin()); }
 
-    if (bin_u - bin_l == 0) { return {fit_status::empty_range, custom}; }
+    if (bin_u - bin_l == 0) { return m_d->record_fit({fit_status::empty_range, custom}, start); }
     // if (hist->Integral(bin_l, bin_u) == 0) return {false, hfp};
 
+    if (m_d->capture)
+    {
+        // the replay gets the rebinned histogram, so it must not rebin again
+        entry captured(*custom);
+        captured.m_d->rebin = 0;
+        m_d->capture->write(hist->GetName(), pars, tools::format_line_entry(hist->GetName(), &captured), *hist,
+                            custom->get_fit_range_min(), custom->get_fit_range_max());
+    }
+
+    const auto rebin = std::max(custom->get_flag_rebin(), 1);
+    const auto range_bins = int2size_t(std::max(bin_u - bin_l + 1, 0)) / int2size_t(rebin);
+    std::string parallel_pars;
+    pars = m_d->parallel_options(pars, range_bins, parallel_pars);
+
     auto fit_result = m_d->generic_fit(custom, custom->m_d.get(), hist->GetName(), hist, pars, gpars);
     if (fit_result.status != fit_status::ok) { custom->restore(); }
 
-    return fit_result;
+    // only completed fits are skipped on resume, failed ones are tried again
+    if (m_d->checkpoint and fit_result.status == fit_status::ok) { m_d->checkpoint->record(checkpoint_name, *custom); }
+
+    return m_d->record_fit(std::move(fit_result), start);
+}
+
+auto fitter::start_workers(std::size_t threads, std::size_t capacity, submit_policy policy,
+                           affinity_policy affinity) -> void
+{
+    stop_workers();
+    auto queue = std::make_shared<detail::fit_queue>([this](TH1* hist, const char* pars, const char* gpars)
+                                                     { return fit(hist, pars, gpars); },
+                                                     detail::plan_bindings(affinity, threads), capacity, policy);
+    std::atomic_store(&m_d->queue, std::move(queue));
+}
+
+auto fitter::stop_workers() -> void
+{
+    if (!m_d) { return; }
+
+    // submitters holding the queue get their fits rejected, it is destroyed by the last of them
+    if (auto queue = std::atomic_exchange(&m_d->queue, std::shared_ptr<detail::fit_queue>())) { queue->stop(); }
+}
+
+auto fitter::pending_fits() const -> std::size_t
+{
+    const auto queue = std::atomic_load(&m_d->queue);
+    return queue ? queue->pending() : 0;
+}
+
+auto fitter::submit(TH1* hist, const char* pars, const char* gpars) -> std::future<fit_result>
+{
+    detail::queued_fit job;
+    auto future = job.promise.get_future();
+
+    const auto queue = std::atomic_load(&m_d->queue);
+    if (!queue)
+    {
+        job.promise.set_value(fit(hist, pars, gpars));
+        return future;
+    }
+
+    job.hist = hist;
+    job.pars = pars;
+    job.gpars = gpars;
+    if (!queue->push(job)) { job.promise.set_value(m_d->record_rejected()); }
+
+    return future;
+}
+
+auto fitter::submit(TH1* hist, fit_callback callback, const char* pars, const char* gpars) -> void
+{
+    const auto queue = std::atomic_load(&m_d->queue);
+    if (!queue)
+    {
+        callback(fit(hist, pars, gpars));
+        return;
+    }
+
+    detail::queued_fit job;
+    job.hist = hist;
+    job.pars = pars;
+    job.gpars = gpars;
+    job.callback = std::move(callback);
+    if (!queue->push(job)) { job.callback(m_d->record_rejected()); }
 }
 
 auto fitter::fit(const char* name, TGraph* graph, const char* pars, const char* gpars) -> fit_result
 {
     entry* hfp = find_or_make(name);
-    if (!hfp) { return {fit_status::missing_entry, hfp}; }
+    if (!hfp) { return m_d->record_missing_entry(); }
 
     return fit(hfp, name, graph, pars, gpars);
 }
@@ -309,19 +667,37 @@ auto fitter::fit(const char* name, TGraph* graph, const char* pars, const char*
 auto fitter::fit(const char* name, TGraph* graph, entry* generic, const char* pars, const char* gpars) -> fit_result
 {
     entry* hfp = find_or_make(name, generic);
-    if (!hfp) { return {fit_status::missing_entry, hfp}; }
+    if (!hfp) { return m_d->record_missing_entry(); }
 
     return fit(hfp, name, graph, pars, gpars);
 }
 
 auto fitter::fit(entry* custom, const char* name, TGraph* graph, const char* pars, const char* gpars) -> fit_result
 {
+    const auto start = detail::metrics_impl::clock::now();
+    detail::alloc_scope alloc(m_d->allocations, detail::alloc_phase::fit);
+
+    std::string checkpoint_name;
+    if (m_d->checkpoint)
+    {
+        checkpoint_name = tools::format_name(name, m_d->name_decorator);
+        if (m_d->checkpoint->is_done(checkpoint_name)) { return m_d->record_fit({fit_status::skipped, custom}, start); }
+    }
+
+    std::lock_guard<std::mutex> lock(detail::entry_mutex(custom));
+
     custom->backup();
 
+    std::string parallel_pars;
+    pars = m_d->parallel_options(pars, int2size_t(graph->GetN()), parallel_pars);
+
     auto fit_result = m_d->generic_fit(custom, custom->m_d.get(), name, graph, pars, gpars);
     if (fit_result.status != fit_status::ok) { custom->restore(); }
 
-    return fit_result;
+    // only completed fits are skipped on resume, failed ones are tried again
+    if (m_d->checkpoint and fit_result.status == fit_status::ok) { m_d->checkpoint->record(checkpoint_name, *custom); }
+
+    return m_d->record_fit(std::move(fit_result), start);
 }
 
 auto fitter::set_name_decorator(std::string decorator) -> void { m_d->name_decorator = std::move(decorator); }
@@ -340,14 +716,58 @@ auto fitter::set_function_style() -> draw_opts& { return set_function_style(-1);
 
 auto fitter::set_qa_checker(fit_qa_checker checker) -> void { m_d->checker = std::move(checker); }
 
+auto fitter::set_qa_summary_checker(fit_qa_summary_checker checker) -> void
+{
+    m_d->summary_checker = std::move(checker);
+}
+
+auto fitter::set_observer(std::shared_ptr<fit_observer> observer) -> void { m_d->observer = std::move(observer); }
+
+auto fitter::set_parallel_threshold(std::size_t bins) -> void { m_d->parallel_bins = bins; }
+
+auto fitter::set_perf_counters(bool enable) -> bool
+{
+    m_d->perf.reset();
+    if (!enable) { return false; }
+
+    if (!detail::perf_monitor::available())
+    {
+        m_d->get_logger().log(log_level::warning, "Hardware performance counters are not available.");
+        return false;
+    }
+
+    m_d->perf = make_unique<detail::perf_monitor>();
+    return true;
+}
+
+auto fitter::perf_counters_by_entry() const -> std::vector<std::pair<std::string, perf_counts>>
+{
+    return m_d->perf ? m_d->perf->by_entry() : std::vector<std::pair<std::string, perf_counts>> {};
+}
+
+auto fitter::perf_counters_by_formula() const -> std::vector<std::pair<std::string, perf_counts>>
+{
+    return m_d->perf ? m_d->perf->by_formula() : std::vector<std::pair<std::string, perf_counts>> {};
+}
+
+auto fitter::set_result_mode(result_mode mode) -> void { m_d->results = mode; }
+
+auto fitter::set_keep_covariance(bool keep) -> void { m_d->keep_covariance = keep; }
+
+auto fitter::set_summary_sidecar(bool enable) -> void { m_d->summary_sidecar = enable; }
+
 auto fitter::print() const -> void
 {
-    for (auto it = m_d->hfpmap.begin(); it != m_d->hfpmap.end(); ++it)
+    for (const auto& item : m_d->hfpmap.snapshot())
     {
-        it->second.print(it->first);
+        item.second.print(item.first);
     }
 }
 
-auto fitter::clear() -> void { m_d->hfpmap.clear(); }
+auto fitter::clear() -> void
+{
+    m_d->hfpmap.clear();
+    m_d->patterns.clear();
+}
 
 } // namespace hf
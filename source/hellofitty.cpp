@@ -19,6 +19,7 @@
 #include "hellofitty.hpp"
 
 #include "parser.hpp"
+#include "tracing.hpp"
 
 namespace hf
 {
@@ -42,6 +43,8 @@ auto HELLOFITTY_EXPORT detect_format(const std::string& line) -> format_version
 
 auto parse_line_entry(const std::string& line, format_version version) -> std::pair<std::string, entry>
 {
+    detail::trace_span span("parse_line_entry");
+
     if (version == hf::format_version::detect) { version = tools::detect_format(line); }
 
     switch (version)
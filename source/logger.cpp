@@ -0,0 +1,453 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+#include "hellofitty.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+/// Result of log_ring::push(), first means the consumer may have seen the ring empty and has to be woken up.
+enum class push_result
+{
+    dropped,
+    queued,
+    first,
+};
+
+/// Single-producer single-consumer ring buffer, the producer is the owning thread, the consumer is the logger
+/// background thread.
+class log_ring final
+{
+public:
+    explicit log_ring(std::size_t capacity)
+        : m_slots(capacity)
+        , m_mask(capacity - 1)
+    {
+    }
+
+    auto push(hf::log_record&& record) -> push_result
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == m_slots.size()) { return push_result::dropped; }
+
+        m_slots[head & m_mask] = std::move(record);
+        // sequentially consistent with pop(), either the consumer sees the record or the producer sees it missed
+        m_head.store(head + 1, std::memory_order_seq_cst);
+        return m_tail.load(std::memory_order_seq_cst) == head ? push_result::first : push_result::queued;
+    }
+
+    auto pop(hf::log_record& record) -> bool
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_seq_cst)) { return false; }
+
+        record = std::move(m_slots[tail & m_mask]);
+        m_tail.store(tail + 1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    /// Called by the producer when its thread exits, nothing is pushed afterwards.
+    auto close() -> void { m_closed.store(true, std::memory_order_release); }
+
+    auto closed() const -> bool { return m_closed.load(std::memory_order_acquire); }
+
+private:
+    std::vector<hf::log_record> m_slots;
+    std::size_t m_mask;
+    std::atomic<std::size_t> m_head {0};
+    std::atomic<std::size_t> m_tail {0};
+    std::atomic<bool> m_closed {false};
+};
+
+auto round_up_pow2(std::size_t value) -> std::size_t
+{
+    std::size_t result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+auto level_name(hf::log_level level) -> const char*
+{
+    switch (level)
+    {
+        case hf::log_level::debug:
+            return "debug";
+        case hf::log_level::info:
+            return "info";
+        case hf::log_level::warning:
+            return "warning";
+        case hf::log_level::error:
+            return "error";
+        default:
+            return "";
+    }
+}
+
+class console_sink final : public hf::log_sink
+{
+public:
+    explicit console_sink(hf::log_formatter formatter)
+        : m_formatter(std::move(formatter))
+    {
+    }
+
+    auto write(const hf::log_record& record) -> void override
+    {
+        std::fputs(m_formatter(record).c_str(), record.level >= hf::log_level::error ? stderr : stdout);
+    }
+
+    auto flush() -> void override
+    {
+        std::fflush(stdout);
+        std::fflush(stderr);
+    }
+
+private:
+    hf::log_formatter m_formatter;
+};
+
+class file_sink final : public hf::log_sink
+{
+public:
+    explicit file_sink(const std::string& filename, hf::log_formatter formatter)
+        : m_file(std::fopen(filename.c_str(), "a"))
+        , m_formatter(std::move(formatter))
+    {
+        if (!m_file) { fmt::print(stderr, "Can't open log file {:s}. Logging disabled.\n", filename); }
+    }
+
+    file_sink(const file_sink&) = delete;
+    auto operator=(const file_sink&) -> file_sink& = delete;
+
+    ~file_sink() override
+    {
+        if (m_file) { std::fclose(m_file); }
+    }
+
+    auto write(const hf::log_record& record) -> void override
+    {
+        if (m_file) { std::fputs(m_formatter(record).c_str(), m_file); }
+    }
+
+    auto flush() -> void override
+    {
+        if (m_file) { std::fflush(m_file); }
+    }
+
+private:
+    std::FILE* m_file;
+    hf::log_formatter m_formatter;
+};
+
+class null_sink final : public hf::log_sink
+{
+public:
+    auto write(const hf::log_record& /*record*/) -> void override {}
+};
+
+} // namespace
+
+namespace hf
+{
+
+namespace detail
+{
+
+struct logger_impl final : std::enable_shared_from_this<logger_impl>
+{
+    std::shared_ptr<log_sink> sink;
+    std::atomic<log_level> level;
+    std::size_t ring_capacity;
+    std::uint64_t id;
+
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<log_ring>> rings;
+
+    std::atomic<std::uint64_t> dropped {0};
+    std::uint64_t dropped_reported {0}; // used only by the writer thread
+
+    std::mutex writer_mutex;
+    std::condition_variable writer_cv;
+    std::condition_variable flushed_cv;
+    std::uint64_t flush_requested {0};
+    std::uint64_t flush_done {0};
+    bool pending {false}; ///< a ring became non-empty or was closed since the last drain
+    bool stop {false};
+    std::thread writer;
+
+    logger_impl(std::shared_ptr<log_sink> log_sink, log_level log_level, std::size_t capacity)
+        : sink(std::move(log_sink))
+        , level(log_level)
+        , ring_capacity(round_up_pow2(capacity))
+        , id(next_id())
+    {
+        writer = std::thread([this] { run(); });
+    }
+
+    static auto next_id() -> std::uint64_t
+    {
+        static std::atomic<std::uint64_t> counter {0};
+        return ++counter;
+    }
+
+    /// Rings of the calling thread, closed when the thread exits so the writer can drop them once drained.
+    struct thread_rings final
+    {
+        struct item
+        {
+            std::weak_ptr<logger_impl> owner;
+            std::shared_ptr<log_ring> ring;
+        };
+
+        std::unordered_map<std::uint64_t, item> items;
+
+        thread_rings() = default;
+        thread_rings(const thread_rings&) = delete;
+        auto operator=(const thread_rings&) -> thread_rings& = delete;
+
+        ~thread_rings()
+        {
+            for (auto& entry : items)
+            {
+                entry.second.ring->close();
+                if (auto owner = entry.second.owner.lock()) { owner->wake(); }
+            }
+        }
+    };
+
+    /// Ring of the calling thread, created at first use. Logger ids are never reused, so the thread-local lookup
+    /// cannot hit a ring of a destroyed logger. Rings of destroyed loggers are released when a new one is created.
+    auto local_ring() -> log_ring&
+    {
+        thread_local thread_rings local;
+
+        auto found = local.items.find(id);
+        if (found != local.items.end()) { return *found->second.ring; }
+
+        for (auto it = local.items.begin(); it != local.items.end();)
+        {
+            if (it->second.owner.expired()) { it = local.items.erase(it); }
+            else { ++it; }
+        }
+
+        auto ring = std::make_shared<log_ring>(ring_capacity);
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            rings.push_back(ring);
+        }
+        local.items.emplace(id, thread_rings::item {weak_from_this(), ring});
+        return *ring;
+    }
+
+    auto drain() -> bool
+    {
+        std::vector<std::shared_ptr<log_ring>> current;
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            current = rings;
+        }
+
+        bool written = false;
+        std::vector<std::shared_ptr<log_ring>> finished;
+        log_record record;
+        for (auto& ring : current)
+        {
+            // checked before popping, a ring closed by then is empty once popped
+            const auto closed = ring->closed();
+            while (ring->pop(record))
+            {
+                sink->write(record);
+                written = true;
+            }
+
+            if (closed) { finished.push_back(ring); }
+        }
+
+        // rings of exited threads are drained, drop them so they are not scanned again
+        if (!finished.empty())
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            rings.erase(std::remove_if(rings.begin(), rings.end(),
+                                       [&](const std::shared_ptr<log_ring>& ring) {
+                                           return std::find(finished.begin(), finished.end(), ring) != finished.end();
+                                       }),
+                        rings.end());
+        }
+
+        const auto lost = dropped.load(std::memory_order_relaxed);
+        if (lost != dropped_reported)
+        {
+            sink->write({log_level::warning,
+                         {{0, fmt::format("Logger ring buffer full, {:d} records dropped", lost - dropped_reported)}}});
+            dropped_reported = lost;
+            written = true;
+        }
+
+        if (written) { sink->flush(); }
+        return written;
+    }
+
+    auto run() -> void
+    {
+        std::unique_lock<std::mutex> lock(writer_mutex);
+        while (true)
+        {
+            const auto requested = flush_requested;
+            const auto stopping = stop;
+            pending = false;
+
+            lock.unlock();
+            while (drain())
+            {
+            }
+            lock.lock();
+
+            if (requested != flush_done)
+            {
+                flush_done = requested;
+                flushed_cv.notify_all();
+            }
+
+            if (stopping) { break; }
+
+            // producers wake the writer only when their ring was empty, so an idle logger does not wake up at all
+            writer_cv.wait(lock, [this] { return stop or pending or flush_requested != flush_done; });
+        }
+    }
+
+    /// Wake the writer, records are waiting or a ring was closed.
+    auto wake() -> void
+    {
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            pending = true;
+        }
+        writer_cv.notify_one();
+    }
+
+    auto flush() -> void
+    {
+        std::unique_lock<std::mutex> lock(writer_mutex);
+        const auto ticket = ++flush_requested;
+        writer_cv.notify_one();
+        flushed_cv.wait(lock, [&] { return flush_done >= ticket; });
+    }
+
+    auto shutdown() -> void
+    {
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            stop = true;
+        }
+        writer_cv.notify_one();
+        if (writer.joinable()) { writer.join(); }
+    }
+};
+
+} // namespace detail
+
+auto colored_formatter(const log_record& record) -> std::string
+{
+    std::string out;
+    for (const auto& segment : record.segments)
+    {
+        if (segment.color) { out += fmt::format(fmt::fg(fmt::rgb(segment.color)), "{:s}", segment.text); }
+        else { out += segment.text; }
+    }
+    out += '\n';
+    return out;
+}
+
+auto plain_formatter(const log_record& record) -> std::string
+{
+    std::string out = fmt::format("[{:s}] ", level_name(record.level));
+    for (const auto& segment : record.segments)
+    {
+        out += segment.text;
+    }
+    out += '\n';
+    return out;
+}
+
+auto make_console_sink(log_formatter formatter) -> std::shared_ptr<log_sink>
+{
+    return std::make_shared<console_sink>(std::move(formatter));
+}
+
+auto make_file_sink(const std::string& filename, log_formatter formatter) -> std::shared_ptr<log_sink>
+{
+    return std::make_shared<file_sink>(filename, std::move(formatter));
+}
+
+auto make_null_sink() -> std::shared_ptr<log_sink> { return std::make_shared<null_sink>(); }
+
+logger::logger(std::shared_ptr<log_sink> sink, log_level level, std::size_t ring_capacity)
+    : m_d {std::make_shared<detail::logger_impl>(sink ? std::move(sink) : make_null_sink(), level, ring_capacity)}
+{
+}
+
+logger::~logger() { m_d->shutdown(); }
+
+auto logger::set_level(log_level level) -> void { m_d->level.store(level, std::memory_order_relaxed); }
+
+auto logger::get_level() const -> log_level { return m_d->level.load(std::memory_order_relaxed); }
+
+auto logger::enabled(log_level level) const -> bool
+{
+    return level != log_level::off and level >= m_d->level.load(std::memory_order_relaxed);
+}
+
+auto logger::log(log_record record) -> void
+{
+    if (!enabled(record.level)) { return; }
+    const auto result = m_d->local_ring().push(std::move(record));
+    if (result == push_result::dropped) { m_d->dropped.fetch_add(1, std::memory_order_relaxed); }
+    else if (result == push_result::first) { m_d->wake(); }
+}
+
+auto logger::log(log_level level, std::string text) -> void
+{
+    if (!enabled(level)) { return; }
+    log({level, {{0, std::move(text)}}});
+}
+
+auto logger::flush() -> void { m_d->flush(); }
+
+auto logger::dropped() const -> std::uint64_t { return m_d->dropped.load(std::memory_order_relaxed); }
+
+auto logger::default_logger() -> const std::shared_ptr<logger>&
+{
+    static const auto instance = std::make_shared<logger>(make_console_sink());
+    return instance;
+}
+
+} // namespace hf
@@ -0,0 +1,146 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hellofitty.hpp"
+
+#include "details.hpp"
+
+#include <TFormula.h>
+#include <TString.h>
+
+#include <functional>
+
+namespace
+{
+/// Heap bytes of the string, zero if the string is stored inline (small string optimization).
+auto string_heap_bytes(const std::string& str) -> size_t
+{
+    const auto* object = reinterpret_cast<const char*>(&str);
+    const std::less<const char*> less;
+    if (!less(str.data(), object) and less(str.data(), object + sizeof(str))) { return 0; }
+    return str.capacity() + 1;
+}
+
+/// Approximate heap of the TF1: its TFormula, parameter values, errors and limits, parameter names and the expression
+/// kept by both objects.
+auto tf1_heap_bytes(const TF1& function, const std::string& body) -> size_t
+{
+    const auto npar = static_cast<size_t>(std::max(function.GetNpar(), 0));
+    return sizeof(TFormula) + npar * (6 * sizeof(Double_t) + 2 * sizeof(TString)) + 3 * (body.size() + 1);
+}
+
+auto styles_bytes(const std::unordered_map<int, hf::draw_opts>& styles) -> size_t
+{
+    if (styles.empty()) { return 0; }
+
+    // node: next pointer and the value, each draw_opts owns its impl
+    const auto node = sizeof(void*) + sizeof(std::pair<const int, hf::draw_opts>) + sizeof(hf::detail::draw_opts_impl);
+    return styles.bucket_count() * sizeof(void*) + styles.size() * node;
+}
+
+} // namespace
+
+namespace hf
+{
+
+namespace detail
+{
+
+auto entry_impl::add_memory_usage(memory_breakdown& usage, std::unordered_set<const formula_impl*>& formulas) const
+    -> void
+{
+    usage.entries += sizeof(entry_impl) + pending_bodies.capacity() * sizeof(std::string) +
+                     instances.partial.capacity() * sizeof(std::unique_ptr<TF1>);
+    for (const auto& body : pending_bodies)
+    {
+        usage.entries += string_heap_bytes(body);
+    }
+
+    usage.params += pars.capacity() * sizeof(param);
+    usage.backups += parameters_backup.capacity() * sizeof(Double_t);
+    usage.styles += styles_bytes(partial_functions_styles);
+
+    if (summary)
+    {
+        // make_shared control block is about two counters and the vtable pointer
+        const auto values = summary->params.capacity() + summary->errors.capacity() + summary->covariance.capacity();
+        usage.fit_results += sizeof(fit_summary) + 2 * sizeof(long) + sizeof(void*) + values * sizeof(double);
+    }
+
+    const auto& funcs = get_functions();
+
+    if (formula and formulas.insert(formula.get()).second)
+    {
+        usage.functions += sizeof(formula_impl) + formula->funcs.capacity() * sizeof(function_impl) +
+                           string_heap_bytes(formula->complete_function_body) +
+                           tf1_heap_bytes(formula->complete_function_object, formula->complete_function_body);
+        for (const auto& func : funcs)
+        {
+            usage.functions +=
+                string_heap_bytes(func.body_string) + tf1_heap_bytes(func.function_obj, func.body_string);
+        }
+    }
+
+    if (instances.complete)
+    {
+        usage.functions += sizeof(TF1) + tf1_heap_bytes(*instances.complete,
+                                                        formula ? formula->complete_function_body : std::string());
+    }
+    for (size_t i = 0; i < instances.partial.size(); ++i)
+    {
+        if (instances.partial[i])
+        {
+            usage.functions += sizeof(TF1) + tf1_heap_bytes(*instances.partial[i], funcs.at(i).body_string);
+        }
+    }
+}
+
+} // namespace detail
+
+auto entry::memory_usage() const -> memory_breakdown
+{
+    memory_breakdown usage;
+    std::unordered_set<const detail::formula_impl*> formulas;
+    m_d->add_memory_usage(usage, formulas);
+    return usage;
+}
+
+auto fitter::memory_usage() const -> memory_breakdown
+{
+    memory_breakdown usage;
+    std::unordered_set<const detail::formula_impl*> formulas;
+
+    // std::map node: color and three links, followed by the key and the entry handle
+    constexpr auto node_overhead = 4 * sizeof(void*);
+
+    m_d->hfpmap.for_each(
+        [&](const std::string& name, const entry& hfp)
+        {
+            usage.registry += node_overhead + sizeof(std::pair<const std::string, entry>) + string_heap_bytes(name);
+
+            // a fit running on another thread changes the functions and backups of the entry
+            std::lock_guard<std::mutex> lock(detail::entry_mutex(&hfp));
+            hfp.m_d->add_memory_usage(usage, formulas);
+        });
+
+    usage.styles += styles_bytes(m_d->partial_functions_styles);
+
+    return usage;
+}
+
+} // namespace hf
@@ -0,0 +1,307 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fmt/core.h>
+
+#include "hellofitty.hpp"
+
+#include "details.hpp"
+#include "metrics.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+auto to_seconds(std::uint64_t ns) -> double { return static_cast<double>(ns) * 1e-9; }
+
+auto to_ns(std::chrono::steady_clock::duration elapsed) -> std::uint64_t
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+auto prometheus_counter(std::string& out, const char* name, const char* help, double value) -> void
+{
+    out += fmt::format("# HELP {0} {1}\n# TYPE {0} counter\n{0} {2}\n", name, help, value);
+}
+
+auto prometheus_gauge(std::string& out, const char* name, const char* help, double value) -> void
+{
+    out += fmt::format("# HELP {0} {1}\n# TYPE {0} gauge\n{0} {2}\n", name, help, value);
+}
+
+} // namespace
+
+namespace hf
+{
+
+namespace detail
+{
+
+auto metrics_impl::record_fit(fitter::fit_status status, fitter::fit_qa_status qa, clock::duration elapsed) -> void
+{
+    fits_attempted.fetch_add(1, std::memory_order_relaxed);
+    fit_status_counts[static_cast<std::size_t>(status)].fetch_add(1, std::memory_order_relaxed);
+
+    if (status == fitter::fit_status::missing_entry or status == fitter::fit_status::empty_range or
+        status == fitter::fit_status::skipped or status == fitter::fit_status::rejected)
+    {
+        return;
+    }
+
+    fit_qa_counts[static_cast<std::size_t>(qa)].fetch_add(1, std::memory_order_relaxed);
+
+    const auto ns = to_ns(elapsed);
+    fit_time_ns.fetch_add(ns, std::memory_order_relaxed);
+
+    const auto seconds = to_seconds(ns);
+    std::size_t bucket = 0;
+    while (bucket < fit_seconds_bounds.size() and seconds > fit_seconds_bounds[bucket])
+    {
+        ++bucket;
+    }
+    fit_time_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+auto metrics_impl::record_import(std::size_t entries, clock::duration elapsed) -> void
+{
+    imports.fetch_add(1, std::memory_order_relaxed);
+    import_entries.fetch_add(entries, std::memory_order_relaxed);
+    import_time_ns.fetch_add(to_ns(elapsed), std::memory_order_relaxed);
+}
+
+auto metrics_impl::record_export(std::size_t entries, clock::duration elapsed) -> void
+{
+    exports.fetch_add(1, std::memory_order_relaxed);
+    export_entries.fetch_add(entries, std::memory_order_relaxed);
+    export_time_ns.fetch_add(to_ns(elapsed), std::memory_order_relaxed);
+}
+
+auto metrics_impl::snapshot() const -> fitter::statistics
+{
+    fitter::statistics stats;
+
+    auto status_count = [&](fitter::fit_status status)
+    { return fit_status_counts[static_cast<std::size_t>(status)].load(std::memory_order_relaxed); };
+    auto qa_count = [&](fitter::fit_qa_status qa)
+    { return fit_qa_counts[static_cast<std::size_t>(qa)].load(std::memory_order_relaxed); };
+
+    stats.fits_attempted = fits_attempted.load(std::memory_order_relaxed);
+    stats.fits_ok = status_count(fitter::fit_status::ok);
+    stats.fits_failed = status_count(fitter::fit_status::failed);
+    stats.fits_empty_range = status_count(fitter::fit_status::empty_range);
+    stats.fits_missing_entry = status_count(fitter::fit_status::missing_entry);
+    stats.fits_skipped = status_count(fitter::fit_status::skipped);
+    stats.fits_rejected = status_count(fitter::fit_status::rejected);
+
+    stats.qa_none = qa_count(fitter::fit_qa_status::none);
+    stats.qa_chi2_better = qa_count(fitter::fit_qa_status::chi2_better);
+    stats.qa_chi2_same = qa_count(fitter::fit_qa_status::chi2_same);
+    stats.qa_chi2_worse = qa_count(fitter::fit_qa_status::chi2_worse);
+
+    stats.fit_seconds = to_seconds(fit_time_ns.load(std::memory_order_relaxed));
+    stats.fit_seconds_bounds.assign(fit_seconds_bounds.begin(), fit_seconds_bounds.end());
+    std::uint64_t cumulative = 0;
+    for (const auto& bucket : fit_time_counts)
+    {
+        cumulative += bucket.load(std::memory_order_relaxed);
+        stats.fit_seconds_counts.push_back(cumulative);
+    }
+
+    stats.imports = imports.load(std::memory_order_relaxed);
+    stats.import_entries = import_entries.load(std::memory_order_relaxed);
+    stats.import_seconds = to_seconds(import_time_ns.load(std::memory_order_relaxed));
+    stats.exports = exports.load(std::memory_order_relaxed);
+    stats.export_entries = export_entries.load(std::memory_order_relaxed);
+    stats.export_seconds = to_seconds(export_time_ns.load(std::memory_order_relaxed));
+
+    stats.uptime_seconds = std::chrono::duration<double>(clock::now() - start_time).count();
+
+    return stats;
+}
+
+auto metrics_impl::write() const -> bool
+{
+    if (filename.empty()) { return false; }
+
+    const auto stats = snapshot();
+    const auto content =
+        format == fitter::metrics_format::json ? format_metrics_json(stats) : format_metrics_prometheus(stats);
+
+    // write to temporary file and rename, so the scraper never sees a partially written file
+    const auto tmp_filename = filename + ".tmp";
+    {
+        std::ofstream metrics_file(tmp_filename);
+        if (!metrics_file.is_open())
+        {
+            fmt::print(stderr, "Can't create metrics file {:s}. Skipping...\n", tmp_filename);
+            return false;
+        }
+        metrics_file << content;
+    }
+
+    return std::rename(tmp_filename.c_str(), filename.c_str()) == 0;
+}
+
+auto metrics_impl::write_if_due() -> void
+{
+    if (!enabled.load(std::memory_order_relaxed)) { return; }
+
+    std::unique_lock<std::mutex> lock(write_mutex, std::try_to_lock);
+    if (!lock.owns_lock() or filename.empty()) { return; }
+
+    const auto now = clock::now();
+    if (now - last_write < interval) { return; }
+
+    last_write = now;
+    write();
+}
+
+auto format_metrics_json(const fitter::statistics& stats) -> std::string
+{
+    std::string buckets;
+    for (std::size_t i = 0; i < stats.fit_seconds_counts.size(); ++i)
+    {
+        if (i != 0) { buckets += ", "; }
+        if (i < stats.fit_seconds_bounds.size())
+        {
+            buckets += fmt::format("{{\"le\": {:g}, \"count\": {:d}}}", stats.fit_seconds_bounds[i],
+                                   stats.fit_seconds_counts[i]);
+        }
+        else { buckets += fmt::format("{{\"le\": \"+Inf\", \"count\": {:d}}}", stats.fit_seconds_counts[i]); }
+    }
+
+    return fmt::format("{{\n"
+                       "  \"fits_attempted\": {:d},\n"
+                       "  \"fits\": {{\"ok\": {:d}, \"failed\": {:d}, \"empty_range\": {:d}, \"missing_entry\": {:d}, "
+                       "\"skipped\": {:d}, \"rejected\": {:d}}},\n"
+                       "  \"qa\": {{\"none\": {:d}, \"chi2_better\": {:d}, \"chi2_same\": {:d}, "
+                       "\"chi2_worse\": {:d}}},\n"
+                       "  \"fit_seconds\": {{\"sum\": {:g}, \"buckets\": [{:s}]}},\n"
+                       "  \"import\": {{\"count\": {:d}, \"entries\": {:d}, \"seconds\": {:g}}},\n"
+                       "  \"export\": {{\"count\": {:d}, \"entries\": {:d}, \"seconds\": {:g}}},\n"
+                       "  \"fits_per_second\": {:g},\n"
+                       "  \"uptime_seconds\": {:g}\n"
+                       "}}\n",
+                       stats.fits_attempted, stats.fits_ok, stats.fits_failed, stats.fits_empty_range,
+                       stats.fits_missing_entry, stats.fits_skipped, stats.fits_rejected,
+                       stats.qa_none, stats.qa_chi2_better, stats.qa_chi2_same, stats.qa_chi2_worse, stats.fit_seconds,
+                       buckets, stats.imports, stats.import_entries, stats.import_seconds, stats.exports,
+                       stats.export_entries, stats.export_seconds, stats.fits_per_second(), stats.uptime_seconds);
+}
+
+auto format_metrics_prometheus(const fitter::statistics& stats) -> std::string
+{
+    std::string out;
+
+    prometheus_counter(out, "hellofitty_fits_attempted_total", "Number of fit requests.",
+                       static_cast<double>(stats.fits_attempted));
+
+    // outcomes only, they sum up to the attempted fits, QA decisions are in hellofitty_fit_qa_total
+    out += "# HELP hellofitty_fits_total Number of fits by result.\n# TYPE hellofitty_fits_total counter\n";
+    out += fmt::format("hellofitty_fits_total{{result=\"ok\"}} {:d}\n", stats.fits_ok);
+    out += fmt::format("hellofitty_fits_total{{result=\"failed\"}} {:d}\n", stats.fits_failed);
+    out += fmt::format("hellofitty_fits_total{{result=\"empty_range\"}} {:d}\n", stats.fits_empty_range);
+    out += fmt::format("hellofitty_fits_total{{result=\"missing_entry\"}} {:d}\n", stats.fits_missing_entry);
+    out += fmt::format("hellofitty_fits_total{{result=\"skipped\"}} {:d}\n", stats.fits_skipped);
+    out += fmt::format("hellofitty_fits_total{{result=\"rejected\"}} {:d}\n", stats.fits_rejected);
+
+    out += "# HELP hellofitty_fit_qa_total Number of QA decisions by outcome.\n"
+           "# TYPE hellofitty_fit_qa_total counter\n";
+    out += fmt::format("hellofitty_fit_qa_total{{qa=\"none\"}} {:d}\n", stats.qa_none);
+    out += fmt::format("hellofitty_fit_qa_total{{qa=\"chi2_better\"}} {:d}\n", stats.qa_chi2_better);
+    out += fmt::format("hellofitty_fit_qa_total{{qa=\"chi2_same\"}} {:d}\n", stats.qa_chi2_same);
+    out += fmt::format("hellofitty_fit_qa_total{{qa=\"chi2_worse\"}} {:d}\n", stats.qa_chi2_worse);
+
+    out += "# HELP hellofitty_fit_duration_seconds Time spent in single fit.\n"
+           "# TYPE hellofitty_fit_duration_seconds histogram\n";
+    for (std::size_t i = 0; i < stats.fit_seconds_counts.size(); ++i)
+    {
+        if (i < stats.fit_seconds_bounds.size())
+        {
+            out += fmt::format("hellofitty_fit_duration_seconds_bucket{{le=\"{:g}\"}} {:d}\n",
+                               stats.fit_seconds_bounds[i], stats.fit_seconds_counts[i]);
+        }
+        else
+        {
+            out += fmt::format("hellofitty_fit_duration_seconds_bucket{{le=\"+Inf\"}} {:d}\n",
+                               stats.fit_seconds_counts[i]);
+        }
+    }
+    out += fmt::format("hellofitty_fit_duration_seconds_sum {:g}\n", stats.fit_seconds);
+    out += fmt::format("hellofitty_fit_duration_seconds_count {:d}\n",
+                       stats.fit_seconds_counts.empty() ? 0 : stats.fit_seconds_counts.back());
+
+    prometheus_counter(out, "hellofitty_imports_total", "Number of imported parameter files.",
+                       static_cast<double>(stats.imports));
+    prometheus_counter(out, "hellofitty_import_entries_total", "Number of imported entries.",
+                       static_cast<double>(stats.import_entries));
+    prometheus_counter(out, "hellofitty_import_seconds_total", "Time spent in import.", stats.import_seconds);
+    prometheus_counter(out, "hellofitty_exports_total", "Number of exported parameter files.",
+                       static_cast<double>(stats.exports));
+    prometheus_counter(out, "hellofitty_export_entries_total", "Number of exported entries.",
+                       static_cast<double>(stats.export_entries));
+    prometheus_counter(out, "hellofitty_export_seconds_total", "Time spent in export.", stats.export_seconds);
+
+    prometheus_gauge(out, "hellofitty_fits_per_second", "Average fitting rate.", stats.fits_per_second());
+    prometheus_gauge(out, "hellofitty_uptime_seconds", "Time since the fitter was created.", stats.uptime_seconds);
+
+    return out;
+}
+
+} // namespace detail
+
+auto fitter::stats() const -> statistics
+{
+    auto stats = m_d->metrics.snapshot();
+
+    const auto count = [&](detail::alloc_phase phase)
+    { return m_d->allocations.count[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed); };
+    const auto bytes = [&](detail::alloc_phase phase)
+    { return m_d->allocations.bytes[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed); };
+
+    stats.alloc_import_count = count(detail::alloc_phase::import);
+    stats.alloc_import_bytes = bytes(detail::alloc_phase::import);
+    stats.alloc_fit_count = count(detail::alloc_phase::fit);
+    stats.alloc_fit_bytes = bytes(detail::alloc_phase::fit);
+    stats.alloc_export_count = count(detail::alloc_phase::export_file);
+    stats.alloc_export_bytes = bytes(detail::alloc_phase::export_file);
+
+    if (const auto queue = std::atomic_load(&m_d->queue)) { stats.worker_bindings = queue->bindings(); }
+
+    return stats;
+}
+
+auto fitter::set_metrics_file(std::string filename, metrics_format format, double interval) -> void
+{
+    std::lock_guard<std::mutex> lock(m_d->metrics.write_mutex);
+    m_d->metrics.filename = std::move(filename);
+    m_d->metrics.enabled.store(!m_d->metrics.filename.empty(), std::memory_order_relaxed);
+    m_d->metrics.format = format;
+    m_d->metrics.interval = std::chrono::duration_cast<detail::metrics_impl::clock::duration>(
+        std::chrono::duration<double>(interval));
+    m_d->metrics.last_write = {};
+}
+
+auto fitter::write_metrics() const -> bool
+{
+    std::lock_guard<std::mutex> lock(m_d->metrics.write_mutex);
+    return m_d->metrics.write();
+}
+
+} // namespace hf
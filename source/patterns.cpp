@@ -0,0 +1,108 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "patterns.hpp"
+
+#include "details.hpp"
+
+#include <algorithm>
+
+namespace hf::detail
+{
+
+auto pattern_matcher::insert(std::string pattern, entry hfp) -> void
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    auto it = std::find_if(m_patterns.begin(), m_patterns.end(),
+                           [&](const pattern_item& item) { return item.first == pattern; });
+    if (it != m_patterns.end())
+    {
+        *it->second = std::move(hfp);
+        return;
+    }
+
+    auto* current = &m_root;
+    for (const auto c : pattern)
+    {
+        if (c == '*' or c == '?') { break; }
+
+        auto& child = current->children[c];
+        if (!child) { child = make_unique<node>(); }
+        current = child.get();
+    }
+
+    current->patterns.push_back(m_patterns.size());
+    m_patterns.emplace_back(std::move(pattern), make_unique<entry>(std::move(hfp)));
+}
+
+auto pattern_matcher::find(const std::string& name) const -> const pattern_item*
+{
+    const pattern_item* found = nullptr;
+
+    // deeper nodes have longer literal prefixes, so the last match along the path is the most specific one
+    const auto* current = &m_root;
+    for (size_t depth = 0; current; ++depth)
+    {
+        for (const auto index : current->patterns)
+        {
+            if (tools::glob_match(m_patterns[index].first, name))
+            {
+                found = &m_patterns[index];
+                break;
+            }
+        }
+
+        if (depth == name.size()) { break; }
+
+        const auto child = current->children.find(name[depth]);
+        current = child != current->children.end() ? child->second.get() : nullptr;
+    }
+
+    return found;
+}
+
+auto pattern_matcher::clear() -> void
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_root.children.clear();
+    m_root.patterns.clear();
+    m_patterns.clear();
+}
+
+auto pattern_matcher::size() const -> std::size_t
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_patterns.size();
+}
+
+auto pattern_matcher::snapshot() const -> std::vector<std::pair<std::string, entry>>
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    std::vector<std::pair<std::string, entry>> out;
+    out.reserve(m_patterns.size());
+    for (const auto& item : m_patterns)
+    {
+        out.emplace_back(item.first, *item.second);
+    }
+    return out;
+}
+
+} // namespace hf::detail
@@ -0,0 +1,189 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "perf_counters.hpp"
+
+#include <algorithm>
+#include <array>
+
+#if defined(__linux__)
+#    include <linux/perf_event.h>
+#    include <sys/ioctl.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+namespace
+{
+
+auto add_sample(hf::perf_counts& counts, const hf::detail::perf_sample& sample) -> void
+{
+    ++counts.fits;
+    counts.cycles += sample.cycles;
+    counts.instructions += sample.instructions;
+    counts.cache_misses += sample.cache_misses;
+    counts.branch_misses += sample.branch_misses;
+}
+
+auto sorted(const std::unordered_map<std::string, hf::perf_counts>& totals)
+    -> std::vector<std::pair<std::string, hf::perf_counts>>
+{
+    std::vector<std::pair<std::string, hf::perf_counts>> out(totals.begin(), totals.end());
+    std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    return out;
+}
+
+#if defined(__linux__)
+constexpr std::size_t events_count = 4;
+
+/// Counter group of one thread, the cycles counter is the group leader.
+class counter_group final
+{
+public:
+    counter_group()
+    {
+        m_fds.fill(-1);
+
+        const std::array<std::uint64_t, events_count> configs {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                               PERF_COUNT_HW_CACHE_MISSES,
+                                                               PERF_COUNT_HW_BRANCH_MISSES};
+        for (std::size_t i = 0; i < events_count; ++i)
+        {
+            perf_event_attr attr {};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+
+            const auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, m_fds[0], 0));
+            if (fd < 0)
+            {
+                // without the leader there is no group at all
+                if (i == 0) { return; }
+                continue;
+            }
+
+            m_fds[i] = fd;
+            ioctl(fd, PERF_EVENT_IOC_ID, &m_ids[i]);
+        }
+    }
+
+    counter_group(const counter_group&) = delete;
+    auto operator=(const counter_group&) -> counter_group& = delete;
+
+    ~counter_group()
+    {
+        for (const auto fd : m_fds)
+        {
+            if (fd >= 0) { close(fd); }
+        }
+    }
+
+    auto valid() const -> bool { return m_fds[0] >= 0; }
+
+    auto start() -> void
+    {
+        ioctl(m_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(m_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    auto stop() -> hf::detail::perf_sample
+    {
+        ioctl(m_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // nr, then value and id of each opened counter
+        std::array<std::uint64_t, 1 + 2 * events_count> buffer {};
+        if (read(m_fds[0], buffer.data(), sizeof(buffer)) < static_cast<ssize_t>(sizeof(std::uint64_t))) { return {}; }
+
+        std::array<std::uint64_t, events_count> values {};
+        const auto nr = std::min<std::uint64_t>(buffer[0], events_count);
+        for (std::uint64_t n = 0; n < nr; ++n)
+        {
+            const auto value = buffer[1 + 2 * n];
+            const auto id = buffer[2 + 2 * n];
+            for (std::size_t i = 0; i < events_count; ++i)
+            {
+                if (m_fds[i] >= 0 and m_ids[i] == id) { values[i] = value; }
+            }
+        }
+
+        return {values[0], values[1], values[2], values[3]};
+    }
+
+private:
+    std::array<int, events_count> m_fds;
+    std::array<std::uint64_t, events_count> m_ids {};
+};
+
+auto thread_group() -> counter_group&
+{
+    thread_local counter_group group;
+    return group;
+}
+#endif
+
+} // namespace
+
+namespace hf::detail
+{
+
+#if defined(__linux__)
+auto perf_monitor::available() -> bool { return thread_group().valid(); }
+
+auto perf_monitor::start() -> bool
+{
+    auto& group = thread_group();
+    if (!group.valid()) { return false; }
+
+    group.start();
+    return true;
+}
+
+auto perf_monitor::stop() -> perf_sample { return thread_group().stop(); }
+#else
+auto perf_monitor::available() -> bool { return false; }
+
+auto perf_monitor::start() -> bool { return false; }
+
+auto perf_monitor::stop() -> perf_sample { return {}; }
+#endif
+
+auto perf_monitor::record(const char* name, const std::string& formula, const perf_sample& sample) -> void
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    add_sample(m_entries[name], sample);
+    add_sample(m_formulas[formula], sample);
+}
+
+auto perf_monitor::by_entry() const -> std::vector<std::pair<std::string, perf_counts>>
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return sorted(m_entries);
+}
+
+auto perf_monitor::by_formula() const -> std::vector<std::pair<std::string, perf_counts>>
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return sorted(m_formulas);
+}
+
+} // namespace hf::detail
@@ -0,0 +1,180 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "registry.hpp"
+
+#include "details.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+namespace hf::detail
+{
+
+auto entry_mutex(const entry* hfp) -> std::mutex&
+{
+    // enough stripes to make collisions between concurrently fitted entries rare
+    static std::array<std::mutex, 1024> stripes;
+
+    const auto address = reinterpret_cast<std::uintptr_t>(hfp);
+    return stripes[(address / alignof(entry)) % stripes.size()];
+}
+
+auto entry_registry::shard_of(const std::string& name) -> shard&
+{
+    return m_shards[std::hash<std::string> {}(name) % shard_count];
+}
+
+auto entry_registry::shard_of(const std::string& name) const -> const shard&
+{
+    return m_shards[std::hash<std::string> {}(name) % shard_count];
+}
+
+auto entry_registry::lock_all() const -> std::vector<std::shared_lock<std::shared_mutex>>
+{
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(shard_count);
+    for (const auto& part : m_shards)
+    {
+        locks.emplace_back(part.mutex);
+    }
+    return locks;
+}
+
+auto entry_registry::find(const std::string& name) const -> entry*
+{
+    const auto& target = shard_of(name);
+    std::shared_lock<std::shared_mutex> lock(target.mutex);
+
+    auto it = target.entries.find(name);
+    if (it == target.entries.end()) { return nullptr; }
+
+    // entries are owned by the registry, constness only reflects the lookup
+    return const_cast<entry*>(&it->second);
+}
+
+auto entry_registry::insert_or_assign(std::string name, entry hfp) -> entry*
+{
+    auto& target = shard_of(name);
+    std::unique_lock<std::shared_mutex> lock(target.mutex);
+
+    auto it = target.entries.find(name);
+    if (it == target.entries.end()) { return &target.entries.emplace(std::move(name), std::move(hfp)).first->second; }
+
+    std::lock_guard<std::mutex> entry_lock(entry_mutex(&it->second));
+    it->second = std::move(hfp);
+    return &it->second;
+}
+
+auto entry_registry::find_or_insert(const std::string& name, const entry& generic) -> std::pair<entry*, bool>
+{
+    auto& target = shard_of(name);
+    std::unique_lock<std::shared_mutex> lock(target.mutex);
+
+    auto it = target.entries.find(name);
+    if (it != target.entries.end()) { return {&it->second, false}; }
+
+    std::unique_lock<std::mutex> generic_lock(entry_mutex(&generic));
+    entry copy(generic);
+    generic_lock.unlock();
+
+    return {&target.entries.emplace(name, std::move(copy)).first->second, true};
+}
+
+auto entry_registry::clear() -> void
+{
+    for (auto& part : m_shards)
+    {
+        std::unique_lock<std::shared_mutex> lock(part.mutex);
+        part.entries.clear();
+    }
+}
+
+auto entry_registry::size() const -> std::size_t
+{
+    std::size_t total = 0;
+    for (const auto& part : m_shards)
+    {
+        std::shared_lock<std::shared_mutex> lock(part.mutex);
+        total += part.entries.size();
+    }
+    return total;
+}
+
+auto entry_registry::items() const -> std::vector<const std::map<std::string, entry>::value_type*>
+{
+    std::vector<const std::map<std::string, entry>::value_type*> all;
+
+    const auto locks = lock_all();
+
+    std::size_t total = 0;
+    for (const auto& part : m_shards)
+    {
+        total += part.entries.size();
+    }
+    all.reserve(total);
+
+    for (const auto& part : m_shards)
+    {
+        for (const auto& item : part.entries)
+        {
+            all.push_back(&item);
+        }
+    }
+    return all;
+}
+
+auto entry_registry::snapshot() const -> std::vector<std::pair<std::string, entry>>
+{
+    const auto all = items();
+
+    std::vector<std::pair<std::string, entry>> entries;
+    entries.reserve(all.size());
+    for (const auto* item : all)
+    {
+        std::lock_guard<std::mutex> entry_lock(entry_mutex(&item->second));
+        entries.emplace_back(item->first, item->second);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    return entries;
+}
+
+auto entry_registry::select(const std::string& prefix, const std::function<bool(const std::string&)>& filter) const
+    -> std::vector<std::pair<std::string, entry*>>
+{
+    std::vector<std::pair<std::string, entry*>> selected;
+    for (const auto& part : m_shards)
+    {
+        std::shared_lock<std::shared_mutex> lock(part.mutex);
+        for (auto it = part.entries.lower_bound(prefix);
+             it != part.entries.end() and it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+        {
+            if (filter and !filter(it->first)) { continue; }
+
+            // entries are owned by the registry, constness only reflects the lookup
+            selected.emplace_back(it->first, const_cast<entry*>(&it->second));
+        }
+    }
+
+    std::sort(selected.begin(), selected.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    return selected;
+}
+
+} // namespace hf::detail
@@ -0,0 +1,102 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hellofitty.hpp"
+
+#include "details.hpp"
+
+#include <regex>
+
+namespace hf
+{
+
+namespace tools
+{
+
+auto is_pattern(const std::string& name) -> bool { return name.find_first_of("*?") != std::string::npos; }
+
+auto glob_match(const std::string& pattern, const std::string& name) -> bool
+{
+    size_t p = 0;
+    size_t n = 0;
+
+    // position of the last star and the name position it is matched up to, for backtracking
+    auto star = std::string::npos;
+    size_t star_n = 0;
+
+    while (n < name.size())
+    {
+        // star first, it is a wildcard even where the name has a literal star
+        if (p < pattern.size() and pattern[p] == '*')
+        {
+            star = p++;
+            star_n = n;
+        }
+        else if (p < pattern.size() and (pattern[p] == '?' or pattern[p] == name[n]))
+        {
+            ++p;
+            ++n;
+        }
+        else if (star != std::string::npos)
+        {
+            p = star + 1;
+            n = ++star_n;
+        }
+        else { return false; }
+    }
+
+    while (p < pattern.size() and pattern[p] == '*')
+    {
+        ++p;
+    }
+
+    return p == pattern.size();
+}
+
+} // namespace tools
+
+auto fitter::select(const std::string& pattern, match_mode mode) const -> selection
+{
+    switch (mode)
+    {
+        case match_mode::prefix:
+            return m_d->hfpmap.select(pattern);
+        case match_mode::glob:
+        {
+            const auto prefix = pattern.substr(0, pattern.find_first_of("*?"));
+            if (prefix.size() == pattern.size())
+            {
+                auto* hfp = m_d->hfpmap.find(pattern);
+                return hfp ? selection {{pattern, hfp}} : selection {};
+            }
+
+            return m_d->hfpmap.select(prefix,
+                                      [&](const std::string& name) { return tools::glob_match(pattern, name); });
+        }
+        case match_mode::regex:
+        {
+            const std::regex expression(pattern);
+            return m_d->hfpmap.select("",
+                                      [&](const std::string& name) { return std::regex_match(name, expression); });
+        }
+    }
+
+    return {};
+}
+
+} // namespace hf
@@ -0,0 +1,457 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hellofitty_server.hpp"
+
+#include "details.hpp"
+#include "server.hpp"
+
+#include <TH1.h>
+
+#include <fmt/core.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr int max_bins = 10000000;
+constexpr int accept_poll_ms = 200;
+
+auto make_address(const std::string& path, sockaddr_un& address) -> bool
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) { return false; }
+
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+auto error_reply(const std::string& message) -> std::string { return fmt::format("error {:s}\n", message); }
+
+} // namespace
+
+namespace hf
+{
+
+namespace detail
+{
+
+auto socket_stream::read_line(std::string& line) -> bool
+{
+    while (true)
+    {
+        const auto newline = m_buffer.find('\n');
+        if (newline != std::string::npos)
+        {
+            line.assign(m_buffer, 0, newline);
+            m_buffer.erase(0, newline + 1);
+            return true;
+        }
+
+        char chunk[4096];
+        const auto received = ::recv(m_fd, chunk, sizeof(chunk), 0);
+        if (received < 0 and errno == EINTR) { continue; }
+        if (received <= 0) { return false; }
+
+        m_buffer.append(chunk, static_cast<size_t>(received));
+    }
+}
+
+auto socket_stream::write(const std::string& data) -> bool
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        // no SIGPIPE if the peer is gone, the error is reported instead
+        const auto written = ::send(m_fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (written < 0 and errno == EINTR) { continue; }
+        if (written <= 0) { return false; }
+
+        sent += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+auto server_impl::accept_loop() -> void
+{
+    auto last_export = clock::now();
+    const auto export_interval =
+        std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(opts.export_interval));
+
+    while (!stopping)
+    {
+        pollfd listener {listen_fd, POLLIN, 0};
+        const auto ready = ::poll(&listener, 1, accept_poll_ms);
+
+        if (ready > 0 and (listener.revents & POLLIN))
+        {
+            const auto fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd >= 0)
+            {
+                std::lock_guard<std::mutex> lock(clients_mutex);
+                clients.push_back(std::make_unique<client_connection>());
+                auto& connection = *clients.back();
+                connection.fd = fd;
+                connection.thread = std::thread([this, &connection] { serve_client(connection); });
+            }
+        }
+
+        reap_clients(false);
+
+        if (opts.export_interval > 0.0 and clock::now() - last_export >= export_interval)
+        {
+            last_export = clock::now();
+            if (fits_since_export.exchange(0) > 0) { hfitter.export_to_file_async(); }
+        }
+    }
+}
+
+auto server_impl::reap_clients(bool all) -> void
+{
+    std::list<std::unique_ptr<client_connection>> finished;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (auto it = clients.begin(); it != clients.end();)
+        {
+            // only the reading side, a reply still being computed is sent before the thread ends
+            if (all) { ::shutdown((*it)->fd, SHUT_RD); }
+
+            if (all or (*it)->done)
+            {
+                auto next = std::next(it);
+                finished.splice(finished.end(), clients, it);
+                it = next;
+            }
+            else { ++it; }
+        }
+    }
+
+    // the descriptor is closed only after its thread ends, so it cannot be reused under the thread
+    for (auto& connection : finished)
+    {
+        if (connection->thread.joinable()) { connection->thread.join(); }
+        ::close(connection->fd);
+    }
+}
+
+auto server_impl::serve_client(client_connection& connection) -> void
+{
+    socket_stream stream(connection.fd);
+
+    std::string line;
+    while (!stopping and stream.read_line(line))
+    {
+        std::istringstream request(line);
+        std::string command;
+        request >> command;
+
+        std::string reply;
+        if (command == "fit") { reply = request_fit(request); }
+        else if (command == "get")
+        {
+            std::string name;
+            request >> name;
+            reply = get_entry(name);
+        }
+        else if (command == "export") { reply = fmt::format("ok {:d}\n", hfitter.export_to_file() ? 1 : 0); }
+        else if (command == "quit") { break; }
+        else { reply = error_reply(fmt::format("unknown command '{:s}'", command)); }
+
+        if (!stream.write(reply)) { break; }
+    }
+
+    connection.done = true;
+}
+
+auto server_impl::request_fit(std::istringstream& request) -> std::string
+{
+    auto job = std::make_unique<fit_job>();
+
+    std::string priority;
+    if (!(request >> priority >> job->name >> job->bins >> job->xmin >> job->xmax))
+    {
+        return error_reply("malformed fit request");
+    }
+    if (priority != "interactive" and priority != "batch") { return error_reply("unknown priority " + priority); }
+    if (job->bins <= 0 or job->bins > max_bins or !(job->xmin < job->xmax)) { return error_reply("invalid binning"); }
+
+    job->contents.resize(int2size_t(job->bins));
+    for (auto& content : job->contents)
+    {
+        if (!(request >> content)) { return error_reply("missing bin contents"); }
+    }
+
+    auto reply = job->reply.get_future();
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        (priority == "interactive" ? interactive_jobs : batch_jobs).push_back(std::move(job));
+    }
+    jobs_cv.notify_one();
+
+    return reply.get();
+}
+
+auto server_impl::work() -> void
+{
+    while (true)
+    {
+        std::unique_ptr<fit_job> job;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex);
+            jobs_cv.wait(lock,
+                         [this] { return workers_stop or !interactive_jobs.empty() or !batch_jobs.empty(); });
+
+            auto& queue = !interactive_jobs.empty() ? interactive_jobs : batch_jobs;
+            if (queue.empty()) { break; }
+
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        try
+        {
+            job->reply.set_value(run_fit(*job));
+        }
+        catch (const std::exception& e)
+        {
+            job->reply.set_value(error_reply(e.what()));
+        }
+    }
+}
+
+auto server_impl::run_fit(const fit_job& job) -> std::string
+{
+    TH1D hist(job.name.c_str(), job.name.c_str(), job.bins, job.xmin, job.xmax);
+    hist.SetDirectory(nullptr);
+    for (int i = 0; i < job.bins; ++i)
+    {
+        hist.SetBinContent(i + 1, job.contents[int2size_t(i)]);
+    }
+
+    const auto result = hfitter.fit(&hist, opts.fit_options.c_str(), "");
+    fits_since_export.fetch_add(1, std::memory_order_relaxed);
+
+    auto reply = fmt::format("ok {:d} {:d}\n", static_cast<int>(result.status), static_cast<int>(result.qa));
+    if (!result.hfp) { return reply + "summary -\nentry -\n"; }
+
+    std::lock_guard<std::mutex> lock(entry_mutex(result.hfp));
+    const auto* summary = result.hfp->get_fit_summary();
+    reply += fmt::format("summary {:s}\n", summary ? tools::format_line_summary(job.name, *summary) : "-");
+    reply += fmt::format("entry {:s}\n", tools::format_line_entry(job.name, result.hfp));
+    return reply;
+}
+
+auto server_impl::get_entry(const std::string& name) -> std::string
+{
+    auto* hfp = hfitter.find_fit(name.c_str());
+    if (!hfp) { return "ok\nentry -\n"; }
+
+    std::lock_guard<std::mutex> lock(entry_mutex(hfp));
+    return fmt::format("ok\nentry {:s}\n", tools::format_line_entry(name, hfp));
+}
+
+auto client_impl::call(const std::string& request) -> std::string
+{
+    if (!stream->write(request)) { throw std::runtime_error("Connection to the fitting server lost."); }
+
+    std::string line;
+    if (!stream->read_line(line)) { throw std::runtime_error("Connection to the fitting server lost."); }
+
+    if (line.compare(0, 6, "error ") == 0) { throw std::runtime_error("Fitting server error: " + line.substr(6)); }
+    if (line.compare(0, 2, "ok") != 0) { throw std::runtime_error("Unexpected reply of the fitting server: " + line); }
+
+    return line.size() > 3 ? line.substr(3) : std::string();
+}
+
+} // namespace detail
+
+server::server(fitter& fitter, options opts)
+    : m_d {make_unique<detail::server_impl>(fitter, std::move(opts))}
+{
+}
+
+server::~server() { stop(); }
+
+auto server::start() -> bool
+{
+    std::lock_guard<std::mutex> lock(m_d->state_mutex);
+    if (m_d->running) { return true; }
+
+    sockaddr_un address;
+    if (!make_address(m_d->opts.socket_path, address)) { return false; }
+
+    const auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) { return false; }
+
+    // a socket left by a crashed server would make bind fail, anything else at the path is not ours to remove
+    struct stat status;
+    if (::lstat(m_d->opts.socket_path.c_str(), &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode))
+        {
+            ::close(fd);
+            return false;
+        }
+        ::unlink(m_d->opts.socket_path.c_str());
+    }
+
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 or ::listen(fd, SOMAXCONN) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // without the auxiliary file there is nothing to export to
+    if (m_d->hfitter.get_aux_file().empty()) { m_d->opts.export_interval = 0.0; }
+
+    m_d->listen_fd = fd;
+    m_d->stopping = false;
+    m_d->workers_stop = false;
+
+    for (size_t i = 0; i < std::max<size_t>(m_d->opts.workers, 1); ++i)
+    {
+        m_d->workers.emplace_back([this] { m_d->work(); });
+    }
+    m_d->acceptor = std::thread([this] { m_d->accept_loop(); });
+
+    m_d->running = true;
+    return true;
+}
+
+auto server::stop() -> void
+{
+    std::unique_lock<std::mutex> lock(m_d->state_mutex);
+    if (!m_d->running) { return; }
+
+    m_d->stopping = true;
+    m_d->acceptor.join();
+
+    // the connections stop reading, clients waiting for their fits still get the replies before they are closed
+    m_d->reap_clients(true);
+
+    {
+        std::lock_guard<std::mutex> jobs_lock(m_d->jobs_mutex);
+        m_d->workers_stop = true;
+    }
+    m_d->jobs_cv.notify_all();
+    for (auto& worker : m_d->workers)
+    {
+        worker.join();
+    }
+    m_d->workers.clear();
+
+    ::close(m_d->listen_fd);
+    ::unlink(m_d->opts.socket_path.c_str());
+    m_d->listen_fd = -1;
+
+    if (m_d->opts.export_interval > 0.0 and m_d->fits_since_export.exchange(0) > 0) { m_d->hfitter.export_to_file(); }
+
+    m_d->running = false;
+    lock.unlock();
+    m_d->state_cv.notify_all();
+}
+
+auto server::wait() -> void
+{
+    std::unique_lock<std::mutex> lock(m_d->state_mutex);
+    m_d->state_cv.wait(lock, [this] { return !m_d->running; });
+}
+
+client::client(const std::string& socket_path)
+    : m_d {make_unique<detail::client_impl>()}
+{
+    sockaddr_un address;
+    if (!make_address(socket_path, address)) { throw std::runtime_error("Socket path too long: " + socket_path); }
+
+    m_d->fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_d->fd < 0 or ::connect(m_d->fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        if (m_d->fd >= 0) { ::close(m_d->fd); }
+        throw std::runtime_error(
+            fmt::format("Can't connect to fitting server {:s}: {:s}", socket_path, std::strerror(errno)));
+    }
+
+    m_d->stream = make_unique<detail::socket_stream>(m_d->fd);
+}
+
+client::~client()
+{
+    m_d->stream->write("quit\n");
+    ::close(m_d->fd);
+}
+
+auto client::fit(const std::string& name, const std::vector<double>& contents, double xmin, double xmax,
+                 request_priority priority) -> fit_reply
+{
+    auto request = fmt::format("fit {:s} {:s} {:d} {:.17g} {:.17g}",
+                               priority == request_priority::interactive ? "interactive" : "batch", name,
+                               contents.size(), xmin, xmax);
+    for (const auto content : contents)
+    {
+        request += fmt::format(" {:.17g}", content);
+    }
+    request += '\n';
+
+    std::istringstream status(m_d->call(request));
+    int fit_status = 0;
+    int qa_status = 0;
+    status >> fit_status >> qa_status;
+
+    fit_reply reply;
+    reply.status = static_cast<fitter::fit_status>(fit_status);
+    reply.qa = static_cast<fitter::fit_qa_status>(qa_status);
+
+    std::string summary_line;
+    if (!m_d->stream->read_line(summary_line) or !m_d->stream->read_line(reply.entry_line))
+    {
+        throw std::runtime_error("Connection to the fitting server lost.");
+    }
+
+    summary_line.erase(0, summary_line.find(' ') + 1);
+    if (summary_line != "-") { reply.summary = tools::parse_line_summary(summary_line).second; }
+
+    reply.entry_line.erase(0, reply.entry_line.find(' ') + 1);
+    if (reply.entry_line == "-") { reply.entry_line.clear(); }
+
+    return reply;
+}
+
+auto client::get(const std::string& name) -> std::string
+{
+    m_d->call(fmt::format("get {:s}\n", name));
+
+    std::string line;
+    if (!m_d->stream->read_line(line)) { throw std::runtime_error("Connection to the fitting server lost."); }
+
+    line.erase(0, line.find(' ') + 1);
+    return line == "-" ? std::string() : line;
+}
+
+auto client::request_export() -> bool { return m_d->call("export\n") == "1"; }
+
+} // namespace hf
@@ -0,0 +1,152 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hellofitty.hpp"
+
+#include "details.hpp"
+
+#include <TF1.h>
+#include <TFitResult.h>
+
+#include <fmt/core.h>
+
+#include <sstream>
+
+namespace hf
+{
+
+auto fit_summary::get_covariance(std::size_t i, std::size_t j) const -> double
+{
+    if (i < j) { std::swap(i, j); }
+
+    const auto index = i * (i + 1) / 2 + j;
+    return index < covariance.size() ? covariance[index] : 0.0;
+}
+
+namespace detail
+{
+
+auto make_fit_summary(const TF1& function, int status, double chi2, const TFitResultPtr& result, bool covariance)
+    -> std::shared_ptr<const fit_summary>
+{
+    auto summary = std::make_shared<fit_summary>();
+    summary->status = status;
+    summary->chi2 = chi2;
+    summary->ndf = function.GetNDF();
+
+    const auto npar = int2size_t(function.GetNpar());
+    summary->params.resize(npar);
+    summary->errors.resize(npar);
+    for (size_t i = 0; i < npar; ++i)
+    {
+        summary->params[i] = function.GetParameter(size_t2int(i));
+        summary->errors[i] = function.GetParError(size_t2int(i));
+    }
+
+    const auto* fit_result = result.Get();
+    if (!fit_result) { return summary; }
+
+    summary->edm = fit_result->Edm();
+
+    if (covariance and fit_result->NPar() == npar)
+    {
+        summary->covariance.reserve(npar * (npar + 1) / 2);
+        for (size_t i = 0; i < npar; ++i)
+        {
+            for (size_t j = 0; j <= i; ++j)
+            {
+                summary->covariance.push_back(
+                    fit_result->CovMatrix(static_cast<unsigned int>(i), static_cast<unsigned int>(j)));
+            }
+        }
+    }
+
+    return summary;
+}
+
+} // namespace detail
+
+namespace tools
+{
+
+auto format_line_summary(const std::string& name, const fit_summary& summary) -> std::string
+{
+    auto out = fmt::format("{:s}\t{:d} {:.17g} {:d} {:.17g} |", name, summary.status, summary.chi2, summary.ndf,
+                           summary.edm);
+    for (const auto error : summary.errors)
+    {
+        out += fmt::format(" {:.17g}", error);
+    }
+
+    if (!summary.covariance.empty())
+    {
+        out += " |";
+        for (const auto value : summary.covariance)
+        {
+            out += fmt::format(" {:.17g}", value);
+        }
+    }
+
+    return out;
+}
+
+auto parse_line_summary(const std::string& line) -> std::pair<std::string, fit_summary>
+{
+    std::istringstream stream(line);
+
+    std::string name;
+    fit_summary summary;
+    std::string separator;
+    if (!(stream >> name >> summary.status >> summary.chi2 >> summary.ndf >> summary.edm >> separator) or
+        separator != "|")
+    {
+        throw format_error(fmt::format("Invalid fit summary in {}", line));
+    }
+
+    auto* values = &summary.errors;
+    std::string token;
+    while (stream >> token)
+    {
+        if (token == "|")
+        {
+            values = &summary.covariance;
+            continue;
+        }
+
+        try
+        {
+            values->push_back(std::stod(token));
+        }
+        catch (const std::exception&)
+        {
+            throw format_error(fmt::format("Invalid value {} in fit summary of {}", token, name));
+        }
+    }
+
+    const auto npar = summary.errors.size();
+    if (!summary.covariance.empty() and summary.covariance.size() != npar * (npar + 1) / 2)
+    {
+        throw format_error(fmt::format("Covariance size does not match parameters in fit summary of {}", name));
+    }
+
+    return {std::move(name), std::move(summary)};
+}
+
+} // namespace tools
+
+} // namespace hf
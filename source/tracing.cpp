@@ -0,0 +1,233 @@
+/*
+    HelloFitty - a versatile histogram fitting tool for ROOT-based projects
+    Copyright (C) 2015-2023  Rafał Lalik <rafallalik@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fmt/core.h>
+
+#include "hellofitty.hpp"
+
+#include "tracing.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <unistd.h>
+#endif
+
+std::atomic<bool> hf::detail::tracing_enabled {false};
+
+namespace
+{
+struct trace_event
+{
+    const char* name;
+    std::string arg;
+    hf::detail::trace_clock::time_point begin;
+    hf::detail::trace_clock::time_point end;
+};
+
+/// Events of a single thread. The mutex is only contended when the trace is collected.
+struct thread_buffer
+{
+    unsigned int tid;
+    std::mutex mutex;
+    std::vector<trace_event> events;
+    bool exited {false}; ///< the thread has ended, the buffer is dropped once its events are written
+};
+
+struct trace_session
+{
+    std::mutex mutex;
+    std::string filename;
+    hf::detail::trace_clock::time_point origin;
+    std::vector<std::shared_ptr<thread_buffer>> buffers;
+    unsigned int next_tid {1};
+};
+
+auto session() -> trace_session&
+{
+    static trace_session s;
+    return s;
+}
+
+/// Drop the buffers of ended threads which have no events left, called with the session mutex held.
+auto drop_exited_buffers(trace_session& s) -> void
+{
+    s.buffers.erase(std::remove_if(s.buffers.begin(), s.buffers.end(),
+                                   [](const std::shared_ptr<thread_buffer>& buffer)
+                                   {
+                                       std::lock_guard<std::mutex> lock(buffer->mutex);
+                                       return buffer->exited and buffer->events.empty();
+                                   }),
+                    s.buffers.end());
+}
+
+/// Marks the buffer of the thread as exited when the thread ends.
+struct buffer_owner
+{
+    std::shared_ptr<thread_buffer> buffer;
+
+    ~buffer_owner()
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        buffer->exited = true;
+    }
+};
+
+/// Register the buffer of a new thread.
+auto make_buffer() -> std::shared_ptr<thread_buffer>
+{
+    auto& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    drop_exited_buffers(s);
+
+    auto buffer = std::make_shared<thread_buffer>();
+    buffer->tid = s.next_tid++;
+    s.buffers.push_back(buffer);
+    return buffer;
+}
+
+auto local_buffer() -> thread_buffer&
+{
+    // buffers are shared with the session, so events survive the thread exit until the trace is written
+    thread_local buffer_owner owner {make_buffer()};
+    return *owner.buffer;
+}
+
+auto escape_json(const std::string& str) -> std::string
+{
+    std::string out;
+    out.reserve(str.size());
+    for (auto c : str)
+    {
+        if (c == '"' or c == '\\') { out += '\\'; }
+        if (static_cast<unsigned char>(c) < 0x20) { continue; }
+        out += c;
+    }
+    return out;
+}
+
+auto process_id() -> long
+{
+#if defined(__unix__) || defined(__APPLE__)
+    return static_cast<long>(getpid());
+#else
+    return 1;
+#endif
+}
+
+} // namespace
+
+namespace hf
+{
+
+namespace detail
+{
+
+auto record_trace_event(const char* name, std::string arg, trace_clock::time_point begin,
+                        trace_clock::time_point end) -> void
+{
+    auto& buffer = local_buffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({name, std::move(arg), begin, end});
+}
+
+} // namespace detail
+
+namespace tools
+{
+
+auto start_tracing(std::string filename) -> bool
+{
+    auto& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    if (detail::tracing_enabled.load()) { return false; }
+
+    for (auto& buffer : s.buffers)
+    {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        buffer->events.clear();
+    }
+    drop_exited_buffers(s);
+
+    s.filename = std::move(filename);
+    s.origin = detail::trace_clock::now();
+    detail::tracing_enabled.store(true);
+
+    return true;
+}
+
+auto stop_tracing() -> bool
+{
+    auto& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    if (!detail::tracing_enabled.exchange(false)) { return false; }
+
+    std::ofstream trace_file(s.filename);
+    if (!trace_file.is_open())
+    {
+        fmt::print(stderr, "Can't create trace file {:s}. Skipping...\n", s.filename);
+        return false;
+    }
+
+    const auto pid = process_id();
+    auto to_us = [&](detail::trace_clock::time_point tp)
+    { return std::chrono::duration<double, std::micro>(tp - s.origin).count(); };
+
+    trace_file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    trace_file << fmt::format(R"({{"name": "process_name", "ph": "M", "pid": {:d}, "args": {{"name": "HelloFitty"}}}})",
+                              pid);
+
+    for (auto& buffer : s.buffers)
+    {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        if (buffer->events.empty()) { continue; }
+
+        trace_file << fmt::format(
+            ",\n"
+            R"({{"name": "thread_name", "ph": "M", "pid": {:d}, "tid": {:d}, "args": {{"name": "thread {:d}"}}}})",
+            pid, buffer->tid, buffer->tid);
+
+        for (const auto& event : buffer->events)
+        {
+            if (event.begin < s.origin) { continue; } // started before the session
+
+            trace_file << fmt::format(
+                ",\n"
+                R"({{"name": "{:s}", "cat": "hellofitty", "ph": "X", "ts": {:.3f}, "dur": {:.3f}, "pid": {:d}, )"
+                R"("tid": {:d}, "args": {{"name": "{:s}"}}}})",
+                event.name, to_us(event.begin), to_us(event.end) - to_us(event.begin), pid, buffer->tid,
+                escape_json(event.arg));
+        }
+        buffer->events.clear();
+    }
+    drop_exited_buffers(s);
+
+    trace_file << "\n]}\n";
+
+    return true;
+}
+
+} // namespace tools
+
+} // namespace hf
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include "hellofitty.hpp"
+
+#include "alloc_stats.hpp"
+
+#include <TF1.h>
+#include <TH1.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+// linked with HelloFitty::alloc_tracker, which replaces the global allocation functions of this binary
+
+TEST(TestsAllocTracker, FitterPhases)
+{
+    const std::string input = "tests_alloc_tracker_in.txt";
+    const std::string output = "tests_alloc_tracker_out.txt";
+    {
+        std::ofstream ofs(input);
+        ofs << "h_foo 0 10 0 gaus(0) | 1 5 1\n";
+    }
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+
+    auto fgaus = std::make_unique<TF1>("f_gaus", "gaus", 0, 10);
+    fgaus->SetParameters(1, 5, 1);
+    auto h_foo = std::make_unique<TH1I>("h_foo", "foo", 10, 0, 10);
+    h_foo->FillRandom("f_gaus");
+
+    // allocations outside of the fitter phases are not attributed
+    ASSERT_EQ(fitter.stats().alloc_import_count, 0u);
+
+    ASSERT_TRUE(fitter.init_from_file(input, output));
+    const auto imported = fitter.stats();
+    ASSERT_GT(imported.alloc_import_count, 0u);
+    ASSERT_GE(imported.alloc_import_bytes, imported.alloc_import_count);
+    ASSERT_EQ(imported.alloc_fit_count, 0u);
+
+    ASSERT_EQ(fitter.fit(h_foo.get(), "BQ0N", "").status, hf::fitter::fit_status::ok);
+    const auto fitted = fitter.stats();
+    ASSERT_GT(fitted.alloc_fit_count, 0u);
+    ASSERT_EQ(fitted.alloc_import_count, imported.alloc_import_count);
+
+    ASSERT_TRUE(fitter.export_to_file());
+    const auto exported = fitter.stats();
+    ASSERT_GT(exported.alloc_export_count, 0u);
+    ASSERT_EQ(exported.alloc_fit_count, fitted.alloc_fit_count);
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST(TestsAllocTracker, AllOverloads)
+{
+    hf::detail::alloc_counters counters;
+    const auto fit = static_cast<std::size_t>(hf::detail::alloc_phase::fit);
+
+    {
+        hf::detail::alloc_scope scope(counters, hf::detail::alloc_phase::fit);
+
+        // called directly, new-expressions may be elided by the compiler
+        ::operator delete(::operator new(16));
+        ::operator delete[](::operator new[](32));
+        ::operator delete(::operator new(64, std::nothrow), std::nothrow);
+        ::operator delete[](::operator new[](128, std::nothrow), std::nothrow);
+    }
+
+    ASSERT_EQ(counters.count[fit].load(), 4u);
+    ASSERT_EQ(counters.bytes[fit].load(), 240u);
+
+    // nothing is counted after the scope ends
+    ::operator delete(::operator new(16));
+    ASSERT_EQ(counters.count[fit].load(), 4u);
+}
+
+TEST(TestsAllocTracker, BytesPerEntry)
+{
+    constexpr std::size_t entries = 1000;
+    const auto fit = static_cast<std::size_t>(hf::detail::alloc_phase::fit);
+
+    hf::entry generic(0, 10);
+    ASSERT_EQ(generic.add_function("gaus(0)"), 0);
+    ASSERT_EQ(generic.add_function("pol1(3)"), 1);
+
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < entries; ++i)
+    {
+        names.push_back("h_" + std::to_string(i));
+    }
+
+    hf::fitter fitter;
+
+    // the fit phase of own counters only collects the allocations of the measured section
+    hf::detail::alloc_counters inserts;
+    {
+        hf::detail::alloc_scope scope(inserts, hf::detail::alloc_phase::fit);
+        for (const auto& name : names)
+        {
+            fitter.insert_parameter(name, generic);
+        }
+    }
+
+    // registry node, entry state and 5 params only, no function objects nor backups
+    const auto bytes_per_entry = inserts.bytes[fit].load() / entries;
+    RecordProperty("bytes_per_entry", std::to_string(bytes_per_entry));
+    ASSERT_LT(bytes_per_entry, 512u);
+
+    // backups are allocated on demand and released by drop
+    auto* hfp = fitter.find_fit("h_0");
+    ASSERT_NE(hfp, nullptr);
+
+    hf::detail::alloc_counters backup;
+    {
+        hf::detail::alloc_scope scope(backup, hf::detail::alloc_phase::fit);
+        hfp->backup();
+    }
+    ASSERT_EQ(backup.bytes[fit].load(), 5 * sizeof(Double_t));
+
+    // the same functions compiled separately share the formula
+    hf::entry other(0, 10);
+    ASSERT_EQ(other.add_function("gaus(0)"), 0);
+
+    hf::detail::alloc_counters shared;
+    int added = -1;
+    {
+        hf::detail::alloc_scope scope(shared, hf::detail::alloc_phase::fit);
+        added = other.add_function("pol1(3)");
+    }
+    ASSERT_EQ(added, 1);
+    ASSERT_LT(shared.bytes[fit].load(), 512u);
+}
@@ -2,10 +2,13 @@
 
 #include "hellofitty.hpp"
 
+#include <TF1.h>
+
 #include <memory>    // for unique_ptr, allocator
 #include <stdexcept> // for out_of_range
 #include <string>    // for string
 #include <tuple>     // for get, tuple
+#include <vector>    // for vector
 
 TEST(TestsEntry, Functions)
 {
@@ -76,6 +79,34 @@ TEST(TestsEntry, Cloning)
     hfp1.clear();
 }
 
+TEST(TestsEntry, SharedFormula)
+{
+    hf::entry hfp1(1, 10);
+    ASSERT_EQ(hfp1.add_function("gaus(0)"), 0);
+    ASSERT_EQ(hfp1.add_function("expo(3)"), 1);
+    hfp1.set_param(0, 5);
+
+    auto hfp2 = hfp1;
+    hfp2.set_fit_range(2, 8);
+
+    // each copy has own function objects with own range and params
+    ASSERT_NE(&hfp1.get_function_object(), &hfp2.get_function_object());
+    ASSERT_EQ(hfp2.get_function_object().GetParameter(0), 5);
+    ASSERT_EQ(hfp1.get_function_object().GetXmin(), 1);
+    ASSERT_EQ(hfp2.get_function_object().GetXmin(), 2);
+
+    hfp2.get_function_object().SetParameter(0, 7);
+    ASSERT_EQ(hfp1.get_function_object().GetParameter(0), 5);
+
+    // adding a function to the copy does not modify the shared formula
+    ASSERT_EQ(hfp2.add_function("pol0(5)"), 2);
+    ASSERT_EQ(hfp1.get_functions_count(), 2);
+    ASSERT_EQ(hfp1.get_function_params_count(), 5);
+    ASSERT_EQ(hfp2.get_functions_count(), 3);
+    ASSERT_EQ(hfp2.get_function_params_count(), 6);
+    ASSERT_STREQ(hfp2.get_function(2), "pol0(5)");
+}
+
 TEST(TestsEntry, Backups)
 {
     hf::entry hfp1(1, 10);
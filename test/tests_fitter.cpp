@@ -6,10 +6,22 @@
 
 #include <TF1.h>
 #include <TH1.h>
+#include <TROOT.h>
 
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 auto make_hist() { return std::make_unique<TH1I>("h_foo", "foo", 10, 0, 10); }
 
@@ -46,6 +58,394 @@ TEST(TestsFitter, InsertParameters)
     fitter.clear();
 }
 
+TEST(TestsFitter, MemoryUsage)
+{
+    hf::fitter fitter;
+    ASSERT_EQ(fitter.memory_usage().total(), 0u);
+
+    auto generic = hf::entry(0, 10);
+    generic.add_function("gaus(0)");
+    generic.add_function("pol1(3)");
+
+    const auto single = generic.memory_usage();
+    ASSERT_GT(single.entries, 0u);
+    ASSERT_EQ(single.params, 5 * sizeof(hf::param));
+    ASSERT_EQ(single.backups, 0u);
+    ASSERT_GT(single.functions, 0u);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        fitter.insert_parameter("h_" + std::to_string(i), generic);
+    }
+
+    // the formula is shared by all entries and counted once
+    const auto usage = fitter.memory_usage();
+    ASSERT_GT(usage.registry, 0u);
+    ASSERT_EQ(usage.entries, 100 * single.entries);
+    ASSERT_EQ(usage.params, 100 * single.params);
+    ASSERT_EQ(usage.backups, 0u);
+    ASSERT_EQ(usage.functions, single.functions);
+
+    // function instance and backup are accounted once created
+    auto* hfp = fitter.find_fit("h_0");
+    ASSERT_NE(hfp, nullptr);
+    hfp->backup();
+    hfp->get_function_object();
+
+    const auto after = fitter.memory_usage();
+    ASSERT_EQ(after.backups, 5 * sizeof(Double_t));
+    ASSERT_GT(after.functions, usage.functions);
+
+    hfp->drop();
+    ASSERT_EQ(fitter.memory_usage().backups, 0u);
+}
+
+TEST(TestsFitter, Columns)
+{
+    hf::fitter fitter;
+
+    auto generic = hf::entry(0, 10);
+    generic.add_function("gaus(0)");
+    generic.add_function("pol1(3)");
+    generic.set_param(1, 5, 4, 6, hf::param::fit_mode::free);
+    generic.set_param(4, 0.5, hf::param::fit_mode::fixed);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        fitter.insert_parameter("h_" + std::to_string(i), generic);
+    }
+
+    hf::param_columns columns;
+    fitter.get_columns(columns);
+
+    ASSERT_EQ(columns.entries_count(), 10u);
+    ASSERT_EQ(columns.params_count(), 50u);
+    ASSERT_EQ(columns.offsets.size(), 11u);
+    ASSERT_EQ(columns.offsets.back(), 50u);
+    ASSERT_EQ(columns.status[0], -1);
+    ASSERT_EQ(columns.errors[0], 0.0);
+
+    const auto first = columns.offsets[0];
+    ASSERT_EQ(columns.values[first + 1], 5);
+    ASSERT_EQ(columns.min[first + 1], 4);
+    ASSERT_EQ(columns.max[first + 1], 6);
+    ASSERT_EQ(columns.has_limits[first + 1], 1);
+    ASSERT_EQ(columns.has_limits[first + 0], 0);
+    ASSERT_EQ(columns.modes[first + 4], hf::param::fit_mode::fixed);
+
+    // write back modified values of all entries
+    for (size_t i = 0; i < columns.entries_count(); ++i)
+    {
+        columns.values[columns.offsets[i]] = static_cast<double>(i);
+    }
+    ASSERT_EQ(fitter.set_columns(columns), 10u);
+
+    for (size_t i = 0; i < columns.entries_count(); ++i)
+    {
+        ASSERT_EQ(fitter.find_fit(columns.names[i].c_str())->get_param(0).value, static_cast<double>(i));
+    }
+
+    // limits are switched by the has_limits column only
+    columns.has_limits[first + 1] = 0;
+    columns.min[first + 2] = 1;
+    columns.max[first + 2] = 2;
+    columns.has_limits[first + 2] = 1;
+    ASSERT_EQ(fitter.set_columns(columns), 10u);
+
+    const auto* hfp = fitter.find_fit(columns.names[0].c_str());
+    ASSERT_FALSE(hfp->get_param(1).has_limits);
+    ASSERT_TRUE(hfp->get_param(2).has_limits);
+    ASSERT_EQ(hfp->get_param(2).min, 1);
+
+    columns.min.pop_back();
+    EXPECT_THROW(fitter.set_columns(columns), std::invalid_argument);
+}
+
+TEST(TestsFitter, Select)
+{
+    hf::fitter fitter;
+
+    auto generic = hf::entry(0, 10);
+    generic.add_function("gaus(0)");
+
+    for (const auto* detector : {"tof", "rpc"})
+    {
+        for (int sector = 0; sector < 6; ++sector)
+        {
+            for (int cell = 0; cell < 10; ++cell)
+            {
+                fitter.insert_parameter(fmt::format("h_{}_sector{}_{}", detector, sector, cell), generic);
+            }
+        }
+    }
+
+    const auto sector3 = fitter.select("h_tof_sector3_", hf::fitter::match_mode::prefix);
+    ASSERT_EQ(sector3.size(), 10u);
+    ASSERT_EQ(sector3.front().first, "h_tof_sector3_0");
+    ASSERT_EQ(sector3.front().second, fitter.find_fit("h_tof_sector3_0"));
+    ASSERT_TRUE(std::is_sorted(sector3.begin(), sector3.end()));
+
+    ASSERT_EQ(fitter.select("h_*_sector3_?").size(), 20u);
+    ASSERT_EQ(fitter.select("h_rpc_sector5_9").size(), 1u);
+    ASSERT_EQ(fitter.select("h_rpc_sector6_*").size(), 0u);
+    ASSERT_EQ(fitter.select("h_(tof|rpc)_sector[12]_0", hf::fitter::match_mode::regex).size(), 4u);
+
+    hf::param_columns columns;
+    fitter.get_columns(columns, sector3);
+    ASSERT_EQ(columns.names.front(), "h_tof_sector3_0");
+    ASSERT_EQ(columns.params_count(), 30u);
+}
+
+TEST(TestsFitter, ConcurrentFindOrMake)
+{
+    constexpr int threads = 8;
+    constexpr int names = 500;
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+
+    auto generic = hf::entry(0, 10);
+    generic.add_function("gaus(0)");
+
+    // all threads create the same names, each name must be inserted once
+    std::vector<std::vector<hf::entry*>> found(threads, std::vector<hf::entry*>(names));
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+    {
+        pool.emplace_back(
+            [&, t]
+            {
+                for (int i = 0; i < names; ++i)
+                {
+                    const auto name = "h_" + std::to_string((i + t * 37) % names);
+                    found[t][(i + t * 37) % names] = fitter.find_or_make(name.c_str(), &generic);
+                }
+            });
+    }
+
+    // iterate the registry concurrently with insertion, entries only grow
+    std::size_t seen = 0;
+    while (seen < names)
+    {
+        const auto now = fitter.memory_usage().params / (3 * sizeof(hf::param));
+        EXPECT_GE(now, seen);
+        seen = now;
+    }
+
+    for (auto& thread : pool)
+    {
+        thread.join();
+    }
+
+    for (int i = 0; i < names; ++i)
+    {
+        ASSERT_NE(found[0][i], nullptr);
+        for (int t = 1; t < threads; ++t)
+        {
+            ASSERT_EQ(found[0][i], found[t][i]);
+        }
+        ASSERT_EQ(fitter.find_fit(("h_" + std::to_string(i)).c_str()), found[0][i]);
+    }
+}
+
+TEST(TestsFitter, AsyncExport)
+{
+    const std::string input = "tests_fitter_async_in.txt";
+    const std::string output = "tests_fitter_async_out.txt";
+    {
+        std::ofstream ofs(input);
+        ofs << "h_a 0 10 0 gaus(0) | 1 2 3\n"
+            << "h_b 0 10 0 gaus(0) | 4 5 6\n";
+    }
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    ASSERT_TRUE(fitter.init_from_file(input, output, hf::fitter::priority_mode::reference));
+
+    auto first = fitter.export_to_file_async();
+    {
+        // the exporter thread may be taking the snapshot
+        auto* hfp = fitter.find_fit("h_b");
+        std::lock_guard<std::mutex> lock(hf::detail::entry_mutex(hfp));
+        hfp->update_param_value(0, 7);
+    }
+    auto second = fitter.export_to_file_async();
+
+    ASSERT_TRUE(first.get());
+    ASSERT_TRUE(second.get());
+    ASSERT_LE(fitter.stats().exports, 2u);
+
+    // the last export always has the latest state
+    std::ifstream ifs(output);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(ifs, line);)
+    {
+        lines.push_back(line);
+    }
+    ASSERT_EQ(lines.size(), 2u);
+    ASSERT_NE(lines[0].find("h_a"), std::string::npos);
+    ASSERT_NE(lines[1].find("h_b"), std::string::npos);
+    ASSERT_NE(lines[1].find(" 7 "), std::string::npos);
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST(TestsFitter, PatternEntries)
+{
+    const std::string input = "tests_fitter_patterns_in.txt";
+    const std::string output = "tests_fitter_patterns_out.txt";
+    {
+        std::ofstream ofs(input);
+        ofs << "h_mass_* 0 10 0 gaus(0) | 1 2 3\n"
+            << "h_mass_pt* 0 10 0 gaus(0) | 4 5 6\n"
+            << "h_mass_eta 0 10 0 gaus(0) | 7 8 9\n";
+    }
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    ASSERT_TRUE(fitter.init_from_file(input, output, hf::fitter::priority_mode::reference));
+
+    // patterns are not entries themselves
+    ASSERT_EQ(fitter.find_fit("h_mass_*"), nullptr);
+    ASSERT_EQ(fitter.find_or_make("h_other"), nullptr);
+
+    // the most specific pattern wins, own entries are preferred
+    auto* pt = fitter.find_or_make("h_mass_pt3");
+    ASSERT_NE(pt, nullptr);
+    ASSERT_EQ(pt->get_param(1).value, 5);
+    ASSERT_EQ(fitter.find_or_make("h_mass_pt3"), pt);
+    ASSERT_EQ(fitter.find_or_make("h_mass_y")->get_param(1).value, 2);
+    ASSERT_EQ(fitter.find_or_make("h_mass_eta")->get_param(1).value, 8);
+
+    // explicit generic takes precedence
+    hf::entry generic(0, 10);
+    generic.add_function("gaus(0)");
+    generic.set_param(1, 11, hf::param::fit_mode::free);
+    ASSERT_EQ(fitter.find_or_make("h_mass_pt4", &generic)->get_param(1).value, 11);
+
+    // instantiated entries share the compiled functions of the pattern
+    const auto functions = fitter.memory_usage().functions;
+    for (int i = 10; i < 20; ++i)
+    {
+        ASSERT_NE(fitter.find_or_make(("h_mass_pt" + std::to_string(i)).c_str()), nullptr);
+    }
+    ASSERT_EQ(fitter.memory_usage().functions, functions);
+
+    // patterns are exported after the entries
+    fitter.clear();
+    fitter.insert_pattern("h_mass_?", generic);
+    ASSERT_EQ(fitter.find_or_make("h_mass_z")->get_param(1).value, 11);
+    ASSERT_EQ(fitter.find_or_make("h_mass_zz"), nullptr);
+    ASSERT_TRUE(fitter.export_to_file());
+
+    std::ifstream ifs(output);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(ifs, line);)
+    {
+        lines.push_back(line);
+    }
+    ASSERT_EQ(lines.size(), 2u);
+    ASSERT_EQ(lines[0].rfind("h_mass_z", 0), 0u);
+    ASSERT_EQ(lines[1].rfind("h_mass_?", 0), 0u);
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST(TestsFitter, CheckpointResume)
+{
+    const std::string input = "tests_fitter_checkpoint_in.txt";
+    const std::string journal = "tests_fitter_checkpoint.journal";
+    {
+        std::ofstream ofs(input);
+        ofs << "h_foo 0 10 0 gaus(0) | 1 2 3\n"
+            << "h_bar 0 10 0 gaus(0) | 4 5 6\n";
+    }
+
+    auto h_foo = make_hist();
+    h_foo->FillRandom("gaus", 1000);
+
+    std::string fitted;
+    {
+        hf::fitter fitter;
+        fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+        ASSERT_TRUE(fitter.init_from_file(input));
+        ASSERT_TRUE(fitter.set_checkpoint(journal, hf::fitter::checkpoint_mode::fresh, 1, 0.0));
+
+        fitter.fit(h_foo.get(), "BQ0N", "");
+
+        // failed fit is not journaled
+        hf::entry hfp_empty(0, 10);
+        auto h_failed = std::make_unique<TH1I>("h_failed", "failed", 10, 0, 10);
+        ASSERT_EQ(fitter.fit(h_failed.get(), &hfp_empty, "BQ0N", "").status, hf::fitter::fit_status::failed);
+        ASSERT_TRUE(fitter.flush_checkpoint().get());
+
+        fitted = hf::tools::format_line_entry("h_foo", fitter.find_fit("h_foo"));
+    }
+
+    // batch cut by a crash, must be ignored
+    {
+        std::ofstream ofs(journal, std::ios::app);
+        ofs << "h_bar 0 10 0 gaus(0) | 7 8 9\n";
+    }
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    ASSERT_TRUE(fitter.init_from_file(input));
+    ASSERT_TRUE(fitter.set_checkpoint(journal, hf::fitter::checkpoint_mode::resume));
+
+    ASSERT_EQ(hf::tools::format_line_entry("h_foo", fitter.find_fit("h_foo")), fitted);
+    ASSERT_EQ(fitter.find_fit("h_bar")->get_param(0).value, 4);
+
+    ASSERT_EQ(fitter.fit(h_foo.get(), "BQ0N", "").status, hf::fitter::fit_status::skipped);
+    ASSERT_EQ(fitter.stats().fits_skipped, 1u);
+
+    hf::entry hfp_empty(0, 10);
+    auto h_failed = std::make_unique<TH1I>("h_failed", "failed", 10, 0, 10);
+    ASSERT_EQ(fitter.fit(h_failed.get(), &hfp_empty, "BQ0N", "").status, hf::fitter::fit_status::failed);
+
+    std::remove(input.c_str());
+    std::remove(journal.c_str());
+}
+
+TEST(TestsFitter, CaptureFits)
+{
+    const std::string capture = "tests_fitter_capture.bin";
+
+    auto h_foo = make_hist();
+    h_foo->FillRandom("gaus", 1000);
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    hf::entry hfp(1, 5);
+    hfp.add_function("gaus(0)");
+    hfp.set_param(0, 10, hf::param::fit_mode::free);
+    hfp.set_param(1, 0, hf::param::fit_mode::free);
+    hfp.set_param(2, 1, hf::param::fit_mode::free);
+
+    const auto before = hf::tools::format_line_entry(h_foo->GetName(), &hfp);
+
+    ASSERT_TRUE(fitter.start_capture(capture));
+    fitter.fit(&hfp, h_foo.get(), "BQ0N", "");
+    fitter.stop_capture();
+
+    const auto fits = hf::tools::read_capture(capture);
+    ASSERT_EQ(fits.size(), 1u);
+    ASSERT_EQ(fits[0].name, h_foo->GetName());
+    ASSERT_EQ(fits[0].options, "BQ0N");
+    ASSERT_EQ(fits[0].entry_line, before);
+
+    const auto first = h_foo->FindBin(1);
+    ASSERT_EQ(fits[0].contents.size(), static_cast<size_t>(h_foo->FindBin(5) - first + 1));
+    ASSERT_EQ(fits[0].edges.size(), fits[0].contents.size() + 1);
+    ASSERT_EQ(fits[0].edges.front(), h_foo->GetXaxis()->GetBinLowEdge(first));
+    ASSERT_EQ(fits[0].contents.front(), h_foo->GetBinContent(first));
+    ASSERT_EQ(fits[0].errors.front(), h_foo->GetBinError(first));
+
+    std::remove(capture.c_str());
+}
+
 TEST(TestsFitter, FitFinding)
 {
     hf::fitter fitter;
@@ -102,6 +502,416 @@ TEST(TestsFitter, FittingHistGoodHFP)
     fitter.clear();
 }
 
+TEST(TestsFitter, Observer)
+{
+    struct counting_observer : hf::fit_observer
+    {
+        std::vector<std::string> stages;
+        std::size_t imported {0};
+        std::size_t exported {0};
+
+        auto before_prepare(const char*, const hf::entry&) -> void override { stages.emplace_back("prepare"); }
+        auto before_minimize(const char*, const hf::entry&) -> void override { stages.emplace_back("minimize"); }
+        auto after_minimize(const char*, const hf::entry&, int) -> void override { stages.emplace_back("minimized"); }
+        auto on_qa(const char*, const hf::entry&, hf::fitter::fit_qa_status, const hf::fit_summary&) -> void override
+        {
+            stages.emplace_back("qa");
+        }
+        auto on_import_progress(const std::string&, std::size_t entries) -> void override { imported = entries; }
+        auto on_export_progress(const std::string&, std::size_t entries, std::size_t) -> void override
+        {
+            exported = entries;
+        }
+    };
+
+    const std::string input = "tests_fitter_observer_in.txt";
+    const std::string output = "tests_fitter_observer_out.txt";
+    {
+        std::ofstream ofs(input);
+        ofs << "h_foo 0 10 0 gaus(0) | 1 5 1\n"
+            << "h_bar 0 10 0 gaus(0) | 4 5 6\n";
+    }
+
+    auto observer = std::make_shared<counting_observer>();
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    fitter.set_observer(observer);
+    ASSERT_TRUE(fitter.init_from_file(input, output));
+    ASSERT_EQ(observer->imported, 2u);
+
+    auto fgaus = std::make_unique<TF1>("f_gaus", "gaus", 0, 10);
+    fgaus->SetParameters(1, 5, 1);
+    auto h_foo = make_hist();
+    h_foo->FillRandom("f_gaus");
+
+    ASSERT_EQ(fitter.fit(h_foo.get(), "BQ0N", "").status, hf::fitter::fit_status::ok);
+    ASSERT_EQ(observer->stages, (std::vector<std::string> {"prepare", "minimize", "minimized", "qa"}));
+
+    ASSERT_TRUE(fitter.export_to_file());
+    ASSERT_EQ(observer->exported, 2u);
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST(TestsFitter, PerfCounters)
+{
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    hf::entry hfp_defaults(0, 10);
+    ASSERT_EQ(hfp_defaults.add_function("gaus(0)"), 0);
+
+    auto fgaus = std::make_unique<TF1>("f_gaus", "gaus", 0, 10);
+    fgaus->SetParameters(1, 5, 1);
+    auto h_foo = make_hist();
+    h_foo->FillRandom("f_gaus");
+
+    // counters are often refused in containers, then nothing is measured
+    const auto enabled = fitter.set_perf_counters(true);
+    ASSERT_EQ(fitter.fit(h_foo.get(), &hfp_defaults, "BQ0N", "").status, hf::fitter::fit_status::ok);
+
+    const auto by_entry = fitter.perf_counters_by_entry();
+    const auto by_formula = fitter.perf_counters_by_formula();
+    if (!enabled)
+    {
+        ASSERT_TRUE(by_entry.empty());
+        ASSERT_TRUE(by_formula.empty());
+        return;
+    }
+
+    ASSERT_EQ(by_entry.size(), 1u);
+    ASSERT_EQ(by_entry[0].first, "h_foo");
+    ASSERT_EQ(by_entry[0].second.fits, 1u);
+    ASSERT_GT(by_entry[0].second.cycles, 0u);
+    ASSERT_EQ(by_formula.size(), 1u);
+    ASSERT_EQ(by_formula[0].first, "gaus(0)");
+
+    // entry without functions has no formula, the fit only fails
+    hf::entry hfp_empty(0, 10);
+    ASSERT_EQ(fitter.fit(h_foo.get(), &hfp_empty, "BQ0N", "").status, hf::fitter::fit_status::failed);
+}
+
+TEST(TestsFitter, SubmitQueue)
+{
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    hf::entry hfp_defaults(0, 10);
+    ASSERT_EQ(hfp_defaults.add_function("gaus(0)"), 0);
+
+    auto fgaus = std::make_unique<TF1>("f_gaus", "gaus", 0, 10);
+    fgaus->SetParameters(1, 5, 1);
+    auto h_foo = make_hist();
+    h_foo->FillRandom("f_gaus");
+    fitter.insert_parameter(h_foo->GetName(), hfp_defaults);
+
+    // without workers the fit runs on the calling thread
+    ASSERT_EQ(fitter.submit(h_foo.get(), "BQ0N", "").get().status, hf::fitter::fit_status::ok);
+
+    fitter.start_workers(1, 1, hf::fitter::submit_policy::fail_fast);
+
+    // the first callback holds the only worker, so the second fit waits and the third one does not fit in the queue
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<hf::fitter::fit_status> first;
+    fitter.submit(
+        h_foo.get(),
+        [&](hf::fitter::fit_result result)
+        {
+            first.set_value(result.status);
+            released.wait();
+        },
+        "BQ0N", "");
+    const auto first_status = first.get_future().get();
+
+    auto second = fitter.submit(h_foo.get(), "BQ0N", "");
+    ASSERT_EQ(fitter.pending_fits(), 1u);
+
+    auto third = fitter.submit(h_foo.get(), "BQ0N", "");
+    ASSERT_EQ(third.get().status, hf::fitter::fit_status::rejected);
+
+    release.set_value();
+    ASSERT_EQ(second.get().status, hf::fitter::fit_status::ok);
+    ASSERT_EQ(first_status, hf::fitter::fit_status::ok);
+
+    fitter.stop_workers();
+    ASSERT_EQ(fitter.pending_fits(), 0u);
+
+    const auto stats = fitter.stats();
+    ASSERT_EQ(stats.fits_ok, 3u);
+    ASSERT_EQ(stats.fits_rejected, 1u);
+}
+
+TEST(TestsFitter, SubmitQueueStopping)
+{
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+    std::atomic<int> calls {0};
+
+    auto queue = std::make_shared<hf::detail::fit_queue>(
+        [&](TH1*, const char*, const char*)
+        {
+            if (calls++ == 0) { started.set_value(); }
+            released.wait();
+            return hf::fitter::fit_result {hf::fitter::fit_status::ok, nullptr};
+        },
+        std::vector<hf::detail::cpu_binding>(1), 1, hf::fitter::submit_policy::block);
+
+    // the worker holds the first fit, the second one fills the queue
+    hf::detail::queued_fit first;
+    ASSERT_TRUE(queue->push(first));
+    started.get_future().wait();
+    hf::detail::queued_fit second;
+    auto second_result = second.promise.get_future();
+    ASSERT_TRUE(queue->push(second));
+
+    // the third producer blocks on the full queue and must be rejected when the queue stops
+    std::atomic<bool> pushing {false};
+    bool pushed = true;
+    std::thread producer(
+        [&, queue]
+        {
+            hf::detail::queued_fit third;
+            pushing = true;
+            pushed = queue->push(third);
+        });
+    while (!pushing)
+    {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::thread stopper([&] { queue->stop(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release.set_value();
+    stopper.join();
+    producer.join();
+
+    ASSERT_FALSE(pushed);
+    ASSERT_EQ(second_result.get().status, hf::fitter::fit_status::ok);
+}
+
+TEST(TestsFitter, SubmitWhileStopping)
+{
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    hf::entry hfp_defaults(0, 10);
+    ASSERT_EQ(hfp_defaults.add_function("gaus(0)"), 0);
+
+    constexpr int producers_count = 4;
+    constexpr int fits_count = 50;
+
+    // each producer fits its own histogram, fits of the same entry are serialized by the entry lock
+    std::vector<std::unique_ptr<TH1I>> hists;
+    for (int p = 0; p < producers_count; ++p)
+    {
+        const auto name = "h_stop_" + std::to_string(p);
+        hists.push_back(std::make_unique<TH1I>(name.c_str(), "foo", 10, 0, 10));
+        hists.back()->FillRandom("gaus", 100);
+        fitter.insert_parameter(name, hfp_defaults);
+    }
+
+    fitter.start_workers(2, 4, hf::fitter::submit_policy::block);
+
+    // workers are stopped while the producers submit, every fit gets a result
+    std::atomic<int> results {0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producers_count; ++p)
+    {
+        producers.emplace_back(
+            [&, p]
+            {
+                for (int i = 0; i < fits_count; ++i)
+                {
+                    const auto status = fitter.submit(hists[static_cast<size_t>(p)].get(), "BQ0N", "").get().status;
+                    if (status == hf::fitter::fit_status::ok or status == hf::fitter::fit_status::rejected or
+                        status == hf::fitter::fit_status::failed)
+                    {
+                        ++results;
+                    }
+                }
+            });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    fitter.stop_workers();
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    ASSERT_EQ(results, producers_count * fits_count);
+    ASSERT_EQ(fitter.pending_fits(), 0u);
+}
+
+TEST(TestsFitter, WorkerAffinity)
+{
+    ASSERT_EQ(hf::detail::parse_cpu_list("0-3,8,10-11"), (std::vector<int> {0, 1, 2, 3, 8, 10, 11}));
+    ASSERT_TRUE(hf::detail::parse_cpu_list("3-1").empty());
+    ASSERT_TRUE(hf::detail::parse_cpu_list("x").empty());
+
+    ASSERT_EQ(hf::detail::format_binding({}), "unpinned");
+    ASSERT_EQ(hf::detail::format_binding({-1, {3}}), "cpu 3");
+    ASSERT_EQ(hf::detail::format_binding({1, {8, 9, 10, 11, 14}}), "node 1: cpus 8-11,14");
+
+    hf::fitter fitter;
+    ASSERT_TRUE(fitter.stats().worker_bindings.empty());
+
+    // pinning may be refused, e.g. in a restricted container, then the worker is reported unpinned
+    fitter.start_workers(2, 8, hf::fitter::submit_policy::block, hf::fitter::affinity_policy::cores);
+    const auto bindings = fitter.stats().worker_bindings;
+    ASSERT_EQ(bindings.size(), 2u);
+    for (const auto& binding : bindings)
+    {
+        ASSERT_TRUE(binding == "unpinned" or binding.compare(0, 4, "cpu ") == 0) << binding;
+    }
+
+    fitter.stop_workers();
+    ASSERT_TRUE(fitter.stats().worker_bindings.empty());
+}
+
+TEST(TestsFitter, ParallelOptions)
+{
+    hf::detail::fitter_impl impl;
+    impl.parallel_bins = 10;
+    std::string storage;
+
+    // the execution policy is left to ROOT until implicit multithreading is enabled
+    ASSERT_FALSE(ROOT::IsImplicitMTEnabled());
+    ASSERT_STREQ(impl.parallel_options("BQ0N", 100, storage), "BQ0N");
+
+    ROOT::EnableImplicitMT(2);
+    if (!ROOT::IsImplicitMTEnabled()) { GTEST_SKIP() << "ROOT built without implicit multithreading"; }
+
+    ASSERT_STREQ(impl.parallel_options("BQ0N", 9, storage), "BQ0N");
+    ASSERT_STREQ(impl.parallel_options("BQ0N", 10, storage), "BQ0N MULTITHREAD");
+    ASSERT_STREQ(impl.parallel_options("BQ0N serial", 100, storage), "BQ0N serial");
+
+    impl.parallel_bins = 0;
+    ASSERT_STREQ(impl.parallel_options("BQ0N", 100, storage), "BQ0N");
+    ROOT::DisableImplicitMT();
+}
+
+TEST(TestsFitter, FitSummary)
+{
+    const std::string input = "tests_fitter_summary_in.txt";
+    const std::string output = "tests_fitter_summary_out.txt";
+    {
+        std::ofstream ofs(input);
+        ofs << "h_foo 0 10 0 gaus(0) | 100 5 1\n";
+    }
+
+    auto h_foo = make_hist();
+    auto fgaus = std::make_unique<TF1>("f_gaus", "gaus", 0, 10);
+    fgaus->SetParameters(1, 5, 1);
+    h_foo->FillRandom("f_gaus");
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    fitter.set_keep_covariance(true);
+    fitter.set_summary_sidecar(true);
+    ASSERT_TRUE(fitter.init_from_file(input, output, hf::fitter::priority_mode::reference));
+    ASSERT_EQ(fitter.find_fit("h_foo")->get_fit_summary(), nullptr);
+
+    ASSERT_EQ(fitter.fit(h_foo.get(), "BQS0N", "").status, hf::fitter::fit_status::ok);
+
+    const auto* summary = fitter.find_fit("h_foo")->get_fit_summary();
+    ASSERT_NE(summary, nullptr);
+    ASSERT_EQ(summary->status, 0);
+    ASSERT_EQ(summary->errors.size(), 3u);
+    ASSERT_GT(summary->errors[1], 0.0);
+    ASSERT_EQ(summary->covariance.size(), 6u);
+    ASSERT_GT(fitter.memory_usage().fit_results, 0u);
+
+    ASSERT_TRUE(fitter.export_to_file());
+
+    // the sidecar is read along the parameters, no refit is needed
+    hf::fitter reader;
+    reader.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    reader.set_summary_sidecar(true);
+    ASSERT_TRUE(reader.init_from_file(output));
+
+    const auto* imported = reader.find_fit("h_foo")->get_fit_summary();
+    ASSERT_NE(imported, nullptr);
+    ASSERT_EQ(imported->ndf, summary->ndf);
+    ASSERT_NEAR(imported->errors[1], summary->errors[1], 1e-9 * summary->errors[1]);
+    ASSERT_NEAR(imported->get_covariance(2, 1), summary->get_covariance(1, 2), 1e-9);
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+    std::remove((output + ".fit").c_str());
+}
+
+TEST(TestsFitter, CompactResults)
+{
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    fitter.set_result_mode(hf::fitter::result_mode::compact);
+
+    int checked = 0;
+    fitter.set_qa_summary_checker(
+        [&](const hf::params_vector& old_pars, double old_chi2, const hf::params_vector& new_pars, double new_chi2,
+            const hf::fit_summary& summary)
+        {
+            ++checked;
+            EXPECT_EQ(summary.params.size(), new_pars.size());
+            return hf::chi2checker()(old_pars, old_chi2, new_pars, new_chi2, summary);
+        });
+
+    hf::entry hfp_defaults(0, 10);
+    ASSERT_EQ(hfp_defaults.add_function("gaus(0)"), 0);
+
+    auto h_foo = make_hist();
+    auto fgaus = std::make_unique<TF1>("f_gaus", "gaus", 0, 10);
+    fgaus->SetParameters(1, 5, 1);
+    h_foo->FillRandom("f_gaus");
+
+    const auto result = fitter.fit(h_foo.get(), &hfp_defaults, "BQS0N", "");
+    ASSERT_EQ(result.status, hf::fitter::fit_status::ok);
+    ASSERT_EQ(checked, 1);
+
+    // the TFitResult is released, only its status and the summary remain
+    ASSERT_EQ(result.result.Get(), nullptr);
+    ASSERT_EQ(int(result.result), 0);
+    ASSERT_NE(result.summary, nullptr);
+    ASSERT_EQ(result.summary->errors.size(), 3u);
+    ASSERT_GE(result.summary->edm, 0.0);
+    ASSERT_EQ(result.summary.get(), result.hfp->get_fit_summary());
+}
+
+TEST(TestsFitter, CompactResultsFitResultChecker)
+{
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+    fitter.set_result_mode(hf::fitter::result_mode::compact);
+
+    // the checker still gets the full result, it is released after the QA
+    double edm = -1.0;
+    fitter.set_qa_checker(
+        [&](const hf::params_vector& old_pars, double old_chi2, const hf::params_vector& new_pars, double new_chi2,
+            const TFitResultPtr& fit_res)
+        {
+            EXPECT_NE(fit_res.Get(), nullptr);
+            if (fit_res.Get()) { edm = fit_res->Edm(); }
+            return hf::chi2checker()(old_pars, old_chi2, new_pars, new_chi2, fit_res);
+        });
+
+    hf::entry hfp_defaults(0, 10);
+    ASSERT_EQ(hfp_defaults.add_function("gaus(0)"), 0);
+
+    auto h_foo = make_hist();
+    auto fgaus = std::make_unique<TF1>("f_gaus", "gaus", 0, 10);
+    fgaus->SetParameters(1, 5, 1);
+    h_foo->FillRandom("f_gaus");
+
+    const auto result = fitter.fit(h_foo.get(), &hfp_defaults, "BQS0N", "");
+    ASSERT_EQ(result.status, hf::fitter::fit_status::ok);
+    ASSERT_GE(edm, 0.0);
+    ASSERT_EQ(result.result.Get(), nullptr);
+    ASSERT_EQ(result.summary->edm, edm);
+}
+
 TEST(TestsFitter, FittingGraph)
 {
     hf::fitter fitter;
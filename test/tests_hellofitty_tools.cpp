@@ -3,9 +3,69 @@
 #include "hellofitty.hpp"
 #include "hellofitty_config.h"
 
+#include <fstream>
+#include <iterator>
+#include <string>
+
 TEST(TestsTools, FormatDetection)
 {
     ASSERT_EQ(hf::tools::detect_format("hist_1 gaus(0) 0  0  1 10  1  2 : 1 3  3 F 2 5"), hf::format_version::v1);
 
     ASSERT_EQ(hf::tools::detect_format("hist_1 1 10 0 gaus(0) | 1  2 : 1 3  3 F 2 5"), hf::format_version::v2);
 }
+
+TEST(TestsTools, GlobMatch)
+{
+    ASSERT_TRUE(hf::tools::glob_match("h_tof_*", "h_tof_sector3_1"));
+    ASSERT_TRUE(hf::tools::glob_match("h_*_sector?_*", "h_tof_sector3_1"));
+    ASSERT_TRUE(hf::tools::glob_match("*", ""));
+    ASSERT_TRUE(hf::tools::glob_match("a*b*c", "aXbYbZc"));
+    ASSERT_TRUE(hf::tools::glob_match("a*", "a*b"));
+    ASSERT_TRUE(hf::tools::glob_match("a*b", "a*b"));
+    ASSERT_FALSE(hf::tools::glob_match("h_tof_*", "h_rpc_sector3_1"));
+    ASSERT_FALSE(hf::tools::glob_match("h_?", "h_12"));
+    ASSERT_FALSE(hf::tools::glob_match("a*b*c", "aXbYbZ"));
+}
+
+TEST(TestsTools, FitSummaryLine)
+{
+    hf::fit_summary summary;
+    summary.status = 0;
+    summary.chi2 = 12.5;
+    summary.ndf = 7;
+    summary.edm = 1e-6;
+    summary.errors = {1.0 / 3, 0.25}; // needs all 17 digits to read back exactly
+    summary.covariance = {0.25, 0.01, 0.0625};
+
+    const auto parsed = hf::tools::parse_line_summary(hf::tools::format_line_summary("hist_1", summary));
+    ASSERT_EQ(parsed.first, "hist_1");
+    ASSERT_EQ(parsed.second.ndf, 7);
+    ASSERT_DOUBLE_EQ(parsed.second.chi2_ndf(), 12.5 / 7);
+    ASSERT_EQ(parsed.second.errors, summary.errors);
+    ASSERT_DOUBLE_EQ(parsed.second.get_covariance(0, 1), 0.01);
+    ASSERT_DOUBLE_EQ(parsed.second.get_covariance(1, 0), 0.01);
+    ASSERT_DOUBLE_EQ(parsed.second.get_covariance(1, 1), 0.0625);
+
+    EXPECT_THROW(hf::tools::parse_line_summary("hist_1 0 12.5 7 | 0.5"), hf::format_error);
+    EXPECT_THROW(hf::tools::parse_line_summary("hist_1 0 12.5 7 0 | 0.5 0.25 | 1"), hf::format_error);
+}
+
+TEST(TestsTools, Tracing)
+{
+    const auto trace_name = tests_bin_path + "test_trace.json";
+
+    ASSERT_FALSE(hf::tools::stop_tracing());
+    ASSERT_TRUE(hf::tools::start_tracing(trace_name));
+    ASSERT_FALSE(hf::tools::start_tracing(trace_name));
+
+    hf::tools::parse_line_entry("hist_1 1 10 0 gaus(0) | 1  2 : 1 3  3 F 2 5");
+
+    ASSERT_TRUE(hf::tools::stop_tracing());
+
+    std::ifstream ifs(trace_name);
+    const std::string trace {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+
+    ASSERT_NE(trace.find("\"traceEvents\""), std::string::npos);
+    ASSERT_NE(trace.find("\"name\": \"parse_line_entry\""), std::string::npos);
+    ASSERT_NE(trace.find("\"name\": \"compile\""), std::string::npos);
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include "hellofitty.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class memory_sink final : public hf::log_sink
+{
+public:
+    auto write(const hf::log_record& record) -> void override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lines.push_back(hf::plain_formatter(record));
+        }
+        written.notify_all();
+    }
+
+    /// Wait until the sink has the number of lines, without flushing the logger.
+    auto wait_for(std::size_t count) -> bool
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return written.wait_for(lock, std::chrono::seconds(5), [&] { return lines.size() >= count; });
+    }
+
+    std::mutex mutex;
+    std::condition_variable written;
+    std::vector<std::string> lines;
+};
+} // namespace
+
+TEST(TestsLogger, Levels)
+{
+    auto sink = std::make_shared<memory_sink>();
+    hf::logger log(sink, hf::log_level::warning);
+
+    ASSERT_FALSE(log.enabled(hf::log_level::info));
+    ASSERT_TRUE(log.enabled(hf::log_level::error));
+
+    log.log(hf::log_level::info, "ignored");
+    log.log(hf::log_level::error, "written");
+    log.flush();
+
+    ASSERT_EQ(sink->lines.size(), 1u);
+    ASSERT_EQ(sink->lines[0], "[error] written\n");
+
+    log.set_level(hf::log_level::off);
+    ASSERT_FALSE(log.enabled(hf::log_level::error));
+}
+
+TEST(TestsLogger, Formatters)
+{
+    hf::log_record record {hf::log_level::info, {{0xff0000, "red"}, {0, " plain"}}};
+
+    ASSERT_EQ(hf::plain_formatter(record), "[info] red plain\n");
+
+    const auto colored = hf::colored_formatter(record);
+    ASSERT_NE(colored.find("\x1b["), std::string::npos);
+    ASSERT_NE(colored.find(" plain\n"), std::string::npos);
+}
+
+TEST(TestsLogger, WakesWriter)
+{
+    auto sink = std::make_shared<memory_sink>();
+    hf::logger log(sink, hf::log_level::info);
+
+    // the writer sleeps without a timeout, each record into an empty ring has to wake it
+    for (std::size_t i = 1; i <= 200; ++i)
+    {
+        log.log(hf::log_level::info, "record");
+        ASSERT_TRUE(sink->wait_for(i));
+    }
+
+    std::thread producer([&] { log.log(hf::log_level::info, "other thread"); });
+    producer.join();
+    ASSERT_TRUE(sink->wait_for(201));
+}
+
+TEST(TestsLogger, ConcurrentProducers)
+{
+    auto sink = std::make_shared<memory_sink>();
+    constexpr int threads_count = 4;
+    constexpr int records_count = 100;
+
+    {
+        hf::logger log(sink, hf::log_level::info, records_count * threads_count);
+
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads_count; ++t)
+        {
+            producers.emplace_back(
+                [&log, t]
+                {
+                    for (int i = 0; i < records_count; ++i)
+                    {
+                        log.log(hf::log_level::info, std::to_string(t));
+                    }
+                });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+    } // logger destructor writes all pending records
+
+    ASSERT_EQ(sink->lines.size(), static_cast<std::size_t>(threads_count * records_count));
+}
+
+TEST(TestsLogger, ThreadChurn)
+{
+    auto sink = std::make_shared<memory_sink>();
+    constexpr int threads_count = 200;
+
+    // rings of exited threads are dropped after draining, their records must not be lost
+    hf::logger log(sink, hf::log_level::info, 4);
+    for (int t = 0; t < threads_count; ++t)
+    {
+        std::thread([&log, t] { log.log(hf::log_level::info, std::to_string(t)); }).join();
+        if (t % 50 == 0) { log.flush(); }
+    }
+    log.flush();
+
+    ASSERT_EQ(sink->lines.size(), static_cast<std::size_t>(threads_count));
+    ASSERT_EQ(log.dropped(), 0u);
+
+    // the thread keeps logging to new loggers after the previous ones are destroyed
+    for (int i = 0; i < 10; ++i)
+    {
+        auto other_sink = std::make_shared<memory_sink>();
+        {
+            hf::logger other(other_sink, hf::log_level::info);
+            other.log(hf::log_level::info, "record");
+        }
+        ASSERT_EQ(other_sink->lines.size(), 1u);
+    }
+}
+
+TEST(TestsLogger, FitterLogger)
+{
+    auto sink = std::make_shared<memory_sink>();
+    auto log = std::make_shared<hf::logger>(sink);
+
+    hf::fitter fitter;
+    fitter.set_logger(log);
+    ASSERT_EQ(&fitter.get_logger(), log.get());
+
+    hf::entry generic(0, 10);
+    generic.add_function("gaus(0)");
+    fitter.find_or_make("h_logger", &generic);
+    log->flush();
+
+    ASSERT_EQ(sink->lines.size(), 2u);
+
+    fitter.set_logger(nullptr);
+    ASSERT_EQ(&fitter.get_logger(), hf::logger::default_logger().get());
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "hellofitty.hpp"
+#include "hellofitty_config.h"
+
+#include <TF1.h>
+#include <TH1.h>
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+namespace
+{
+auto read_file(const std::string& filename) -> std::string
+{
+    std::ifstream ifs(filename);
+    return {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+}
+} // namespace
+
+TEST(TestsMetrics, Counters)
+{
+    hf::fitter fitter;
+    auto h_foo = std::make_unique<TH1I>("h_metrics", "foo", 10, 0, 10);
+
+    auto fgaus = std::make_unique<TF1>("f_gaus_metrics", "gaus", 0, 10);
+    fgaus->SetParameters(1, 5, 1);
+    h_foo->FillRandom("f_gaus_metrics");
+
+    hf::entry hfp_defaults(0, 10);
+    ASSERT_EQ(hfp_defaults.add_function("gaus(0)"), 0);
+
+    ASSERT_EQ(fitter.fit(h_foo.get(), "", "").status, hf::fitter::fit_status::missing_entry);
+    ASSERT_EQ(fitter.fit(h_foo.get(), &hfp_defaults, "", "").status, hf::fitter::fit_status::ok);
+
+    const auto stats = fitter.stats();
+    ASSERT_EQ(stats.fits_attempted, 2u);
+    ASSERT_EQ(stats.fits_ok, 1u);
+    ASSERT_EQ(stats.fits_missing_entry, 1u);
+    ASSERT_EQ(stats.qa_none + stats.qa_chi2_better + stats.qa_chi2_same + stats.qa_chi2_worse, 1u);
+    ASSERT_EQ(stats.fit_seconds_counts.size(), stats.fit_seconds_bounds.size() + 1);
+    ASSERT_EQ(stats.fit_seconds_counts.back(), 1u);
+}
+
+TEST(TestsMetrics, MetricsFile)
+{
+    hf::fitter fitter;
+    ASSERT_FALSE(fitter.write_metrics());
+
+    const auto json_name = tests_bin_path + "test_metrics.json";
+    fitter.set_metrics_file(json_name, hf::fitter::metrics_format::json);
+    ASSERT_TRUE(fitter.write_metrics());
+
+    const auto json = read_file(json_name);
+    ASSERT_NE(json.find("\"fits_attempted\": 0"), std::string::npos);
+    ASSERT_NE(json.find("\"fits\": {\"ok\": 0"), std::string::npos);
+    ASSERT_EQ(json.find("\"worse\""), std::string::npos);
+    ASSERT_NE(json.find("\"fits_per_second\""), std::string::npos);
+
+    const auto prom_name = tests_bin_path + "test_metrics.prom";
+    fitter.set_metrics_file(prom_name, hf::fitter::metrics_format::prometheus);
+    ASSERT_TRUE(fitter.write_metrics());
+
+    const auto prom = read_file(prom_name);
+    ASSERT_NE(prom.find("# TYPE hellofitty_fit_duration_seconds histogram"), std::string::npos);
+    ASSERT_NE(prom.find("hellofitty_fits_attempted_total 0"), std::string::npos);
+    ASSERT_NE(prom.find("hellofitty_fits_total{result=\"ok\"} 0"), std::string::npos);
+    ASSERT_EQ(prom.find("hellofitty_fits_total{result=\"attempted\"}"), std::string::npos);
+    ASSERT_EQ(prom.find("hellofitty_fits_total{result=\"worse\"}"), std::string::npos);
+    ASSERT_NE(prom.find("hellofitty_fit_duration_seconds_bucket{le=\"+Inf\"} 0"), std::string::npos);
+}
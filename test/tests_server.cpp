@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include "hellofitty.hpp"
+#include "hellofitty_server.hpp"
+
+#include <TMath.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+TEST(TestsServer, FitOverSocket)
+{
+    const std::string socket_path = "tests_server.sock";
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+
+    hf::entry hfp(0, 10);
+    hfp.add_function("gaus(0)");
+    hfp.set_param(0, 100, hf::param::fit_mode::free);
+    hfp.set_param(1, 4, hf::param::fit_mode::free);
+    hfp.set_param(2, 2, hf::param::fit_mode::free);
+    fitter.insert_parameter("h_foo", hfp);
+
+    hf::server::options opts;
+    opts.socket_path = socket_path;
+    opts.fit_options = "BQS0N";
+    opts.export_interval = 0.0;
+
+    hf::server server(fitter, opts);
+    ASSERT_TRUE(server.start());
+
+    std::vector<double> contents(50);
+    for (size_t i = 0; i < contents.size(); ++i)
+    {
+        const auto x = (static_cast<double>(i) + 0.5) * 0.2;
+        contents[i] = 1000 * TMath::Gaus(x, 5, 1);
+    }
+
+    // concurrent clients with both priority classes
+    std::vector<hf::client::fit_reply> replies(4);
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < replies.size(); ++c)
+    {
+        clients.emplace_back(
+            [&, c]
+            {
+                hf::client client(socket_path);
+                replies[c] = client.fit("h_foo", contents, 0, 10,
+                                        c % 2 ? hf::request_priority::batch : hf::request_priority::interactive);
+            });
+    }
+    for (auto& thread : clients)
+    {
+        thread.join();
+    }
+
+    for (const auto& reply : replies)
+    {
+        ASSERT_EQ(reply.status, hf::fitter::fit_status::ok);
+        ASSERT_TRUE(reply.summary.has_value());
+        ASSERT_EQ(reply.summary->errors.size(), 3u);
+        ASSERT_NEAR(hf::tools::parse_line_entry(reply.entry_line).second.get_param(1).value, 5, 0.1);
+    }
+
+    hf::client client(socket_path);
+    ASSERT_NE(client.get("h_foo").find("h_foo"), std::string::npos);
+    ASSERT_TRUE(client.get("h_bar").empty());
+    ASSERT_EQ(client.fit("h_bar", contents, 0, 10).status, hf::fitter::fit_status::missing_entry);
+    EXPECT_THROW(client.fit("h_foo", {}, 0, 10), std::runtime_error);
+
+    server.stop();
+    EXPECT_THROW(hf::client {socket_path}, std::runtime_error);
+}
+
+TEST(TestsServer, SocketPathSafety)
+{
+    const std::string socket_path = "tests_server_safety.sock";
+    {
+        std::ofstream ofs(socket_path);
+        ofs << "h_foo 0 10 0 gaus(0) | 1 2 3\n";
+    }
+
+    hf::fitter fitter;
+    fitter.set_logger(std::make_shared<hf::logger>(hf::make_null_sink()));
+
+    hf::server::options opts;
+    opts.socket_path = socket_path;
+
+    // a regular file at the socket path is not removed
+    {
+        hf::server server(fitter, opts);
+        ASSERT_FALSE(server.start());
+        std::ifstream ifs(socket_path);
+        ASSERT_TRUE(ifs.is_open());
+    }
+    std::remove(socket_path.c_str());
+
+    // a socket left by a crashed server is replaced
+    {
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+        const auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        ASSERT_EQ(::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+        ::close(fd);
+    }
+
+    // without the auxiliary file nothing is exported
+    hf::server server(fitter, opts);
+    ASSERT_TRUE(server.start());
+
+    hf::client client(socket_path);
+    ASSERT_FALSE(client.request_export());
+    server.stop();
+    std::remove(socket_path.c_str());
+}